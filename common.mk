@@ -23,6 +23,10 @@ ifneq "$(strip $(shell uname -m | grep 64))" ""
 	SUFFIX := $(SUFFIX)64
 endif
 
+# compiles the CPU library and links every tool against it, so that they agree on libstdc++ and libgomp.  It must accept -mavx2
+# and -mavx512f, set it in settings.mk for another compiler
+CPU_CXX ?= g++
+
 ifeq ($(dbg),1)
 	OPTIONS := -g
 	SUFFIX := $(SUFFIX)D
@@ -63,7 +67,8 @@ endif
 
 MAGICK := $(MAGICK_INCLUDE_PATH) $(MAGICK_LIB_PATH) -lMagick++
 
-FFTW := $(FFTW_INCLUDE_PATH) $(FFTW_LIB_PATH) -lfftw3f -lfftw3f_threads
+# FFTW's OpenMP threads, so that its transforms run on the same worker pool as the library's kernels
+FFTW := $(FFTW_INCLUDE_PATH) $(FFTW_LIB_PATH) -lfftw3f_omp -lfftw3f
 
 CUDA := $(CUDA_INCLUDE_PATHS) $(CUDA_LIB_PATHS)
 ifneq ($(cpu), 1)
@@ -1,76 +1,156 @@
-/*
-libMeshlessVis
-Copyright (C) 2008 Andrew Corrigan
-
-This program is free software; you can redistribute it and/or
-modify it under the terms of the GNU General Public License
-as published by the Free Software Foundation; either version 2
-of the License, or (at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program; if not, write to the Free Software
-Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
-*/
-
-#ifndef MESHLESS_H_
-#define MESHLESS_H_
-
-#include <vector_types.h>
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-enum BasisFunctionId
-{
-	SPH,
-	GAUSSIAN,
-	WENDLAND_D3_C2
-};
-
-typedef struct __align__(16)
-{
-	float3 position;
-	float weight;
-} Constraint;
-
-typedef struct
-{
-	int number_of_terms, d_number_of_terms;
-	BasisFunctionId basis_function_id;
-
-	Constraint* h_constraints, *d_constraints;
-	float*  h_radii,   *d_radii;
-} Group;
-
-typedef struct
-{
-	Group* groups;
-	int number_of_groups;
-
-} MeshlessDataset;
-
-MeshlessDataset get_simple_meshless_dataset(int number_of_terms, Constraint* h_constraints, float* h_radii, BasisFunctionId basis_function_id);
-
-void delete_meshless_dataset(MeshlessDataset meshless_dataset);
-void delete_meshless_datasets(MeshlessDataset* meshless_datasets, int number_of_datasets);
-
-int get_number_of_terms(MeshlessDataset* meshless_dataset);
-
-void shift_meshless_dataset(MeshlessDataset* meshless_dataset, float x, float y, float z);
-void shift_meshless_datasets(MeshlessDataset* meshless_dataset, int number_of_datasets, float x, float y, float z);
-
-void load_meshless_datasets_from_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets);
-void save_meshless_datasets_to_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif /*MESHLESS_H_*/
+/*
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef MESHLESS_H_
+#define MESHLESS_H_
+
+#include <vector_types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+enum BasisFunctionId
+{
+	SPH,
+	GAUSSIAN,
+	WENDLAND_D3_C2
+};
+
+typedef struct __align__(16)
+{
+	float3 position;
+	float weight;
+} Constraint;
+
+struct GroupSpectrum;
+struct GroupTree;
+struct MeshlessMapping;
+
+typedef struct
+{
+	int number_of_terms, d_number_of_terms;
+	BasisFunctionId basis_function_id;
+
+	Constraint* h_constraints, *d_constraints;
+	float*  h_radii,   *d_radii;
+
+	// the CPU backend registers a structure-of-arrays copy of h_constraints here instead of d_constraints, each array is d_number_of_terms long
+	float* d_x, *d_y, *d_z, *d_weights;
+
+	// if the CPU backend finds only a few distinct radii it stores them here, and the index of each term's radius in d_radius_indices
+	int number_of_distinct_radii;
+	float* d_distinct_radii;
+	int* d_radius_indices;
+
+	// the CPU backend caches the group's 3D spectrum here for VIS_SPECTRUM_SLICE, it is freed when the dataset is unregistered
+	struct GroupSpectrum* d_spectrum;
+
+	// and the octree of its terms for VIS_HIERARCHICAL, built when it's first used if the group's terms share a radius
+	struct GroupTree* d_tree;
+
+	// and copies of its arrays on each NUMA node when VisConfig::replicate_terms is set, 0 otherwise
+	struct GroupReplicas* d_replicas;
+} Group;
+
+typedef struct
+{
+	Group* groups;
+	int number_of_groups;
+
+	// bumped whenever the host data of the terms changes, so that cached registrations of the dataset get remade (see VisRegistrationCache)
+	int generation;
+
+	// the file the host arrays of the groups point into if the dataset was loaded with load_meshless_datasets_from_binary_file, 0 if
+	// they were allocated with new[]
+	struct MeshlessMapping* mapping;
+} MeshlessDataset;
+
+MeshlessDataset get_simple_meshless_dataset(int number_of_terms, Constraint* h_constraints, float* h_radii, BasisFunctionId basis_function_id);
+
+void delete_meshless_dataset(MeshlessDataset meshless_dataset);
+void delete_meshless_datasets(MeshlessDataset* meshless_datasets, int number_of_datasets);
+
+int get_number_of_terms(MeshlessDataset* meshless_dataset);
+
+void shift_meshless_dataset(MeshlessDataset* meshless_dataset, float x, float y, float z);
+void shift_meshless_datasets(MeshlessDataset* meshless_dataset, int number_of_datasets, float x, float y, float z);
+
+// The text format and the binary and compressed ones below are named .sph, .sphb and .sphz, as meshless_convert writes them and vis_wx
+// lists them.  The loaders don't go by the name though.  This one loads any of the three, depending on the first bytes of the file.  Text is parsed in parallel from a
+// mapping of the file and written in parallel, with the same results as reading and writing it with iostreams in the classic locale.
+void load_meshless_datasets_from_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets);
+void save_meshless_datasets_to_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets);
+
+// The binary format is little-endian and every section starts on a 64 byte boundary:
+//   header:          char magic[8] = "MLSVBIN", uint32 version = 1, uint32 number_of_datasets, then number_of_datasets uint64 offsets of
+//                    the timesteps
+//   timestep:        uint32 number_of_groups, uint32 unused, then per group { uint64 number_of_terms, uint32 basis_function_id,
+//                    uint32 has_radii, uint64 constraints_offset, uint64 radii_offset }
+//   group sections:  number_of_terms Constraint records (float x, y, z, weight), and number_of_terms float radii if the group has them
+// The loader maps the file copy-on-write and points h_constraints and h_radii straight into the mapping, so loading only reads the
+// pages that get used and shift_meshless_dataset still works. The mapping is released when the last of its datasets is deleted.
+// Both return false if the file can't be opened or isn't valid, the loader leaves no datasets then.
+bool load_meshless_datasets_from_binary_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets);
+bool save_meshless_datasets_to_binary_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets);
+bool is_binary_meshless_file(const char* filename);
+
+// Asks the system to start reading the pages of terms [first_term, first_term+number_of_terms) of a group of a dataset loaded from
+// a binary file in the background, clipped to the group, and returns straight away.  The pages are only cached by the system, which
+// drops them again as it needs the memory.  Does nothing for a dataset whose arrays aren't mapped, or on systems before Windows 8.
+void meshless_dataset_prefetch_terms(MeshlessDataset* meshless_dataset, int group, int first_term, int number_of_terms);
+
+// The compressed format stores each coordinate of the positions on a fixed-point grid of position_bits bits (at most 24) over the
+// bounding box of all the positions in the file, and weights and radii exactly.  Every keyframe_interval'th timestep, and every one
+// whose groups differ from the timestep before, is a keyframe stored on its own, the others are stored as differences from the
+// timestep before.  Everything is then entropy coded, in blocks that are coded and decoded in parallel straight into the arrays of the
+// groups.  position_error, if not 0, is set to the largest difference between a coordinate as given and as stored, which is at most
+// half the grid step along that axis (plus float rounding), and is kept in the file.
+bool load_meshless_datasets_from_compressed_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets);
+bool save_meshless_datasets_to_compressed_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets, int position_bits, int keyframe_interval, float* position_error);
+bool is_compressed_meshless_file(const char* filename);
+
+// Reads the timesteps of a file in any of the formats one at a time, so that only the one in use is in memory instead of the whole run.
+// Opening the file indexes where each timestep starts, from the header of a binary or compressed file or by scanning the headers of a
+// text file.  A timestep of a compressed file is decoded from the keyframe before it, or from the one decoded last if that's closer.
+// Seeking to a timestep loads it in place of the one loaded before and returns it, the dataset stays valid until the next seek or the
+// reader is closed, and seeking to the loaded one again returns it as it is, shifts included.  Each load gets a generation of its own.
+typedef struct MeshlessDatasetReader MeshlessDatasetReader;
+
+// 0 if the file can't be opened
+MeshlessDatasetReader* meshless_dataset_reader_open(const char* filename);
+void meshless_dataset_reader_close(MeshlessDatasetReader* reader);
+
+int meshless_dataset_reader_get_number_of_datasets(MeshlessDatasetReader* reader);
+// the index of the loaded timestep, -1 if none is
+int meshless_dataset_reader_get_index(MeshlessDatasetReader* reader);
+
+// 0 if k is out of range or the timestep isn't valid, no timestep is loaded then
+MeshlessDataset* meshless_dataset_reader_seek(MeshlessDatasetReader* reader, int k);
+// the timestep after the loaded one, or the first if none is, 0 after the last
+MeshlessDataset* meshless_dataset_reader_next(MeshlessDatasetReader* reader);
+// the position_error of a compressed file, 0 for the other formats
+float meshless_dataset_reader_get_position_error(MeshlessDatasetReader* reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*MESHLESS_H_*/
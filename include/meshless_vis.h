@@ -1,100 +1,250 @@
-/*
-libMeshlessVis
-Copyright (C) 2008 Andrew Corrigan
-
-This program is free software; you can redistribute it and/or
-modify it under the terms of the GNU General Public License
-as published by the Free Software Foundation; either version 2
-of the License, or (at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program; if not, write to the Free Software
-Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
-*/
-
-#ifndef MESHLESS_VISh
-#define MESHLESS_VISh
-
-#include "meshless.h"
-#include <vector_functions.h>
-#include <builtin_types.h>
-#include <cufft.h>
-#include <GL/glew.h>
-
-#ifdef _LIBMESHLESSVIS_USE_CPU
-#include <fftw3.h>
-#endif
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-	
-typedef struct 
-{
-	// variables prefixed with an underscore are private and should only be modified a vis_config_< do something > function
-	
-	float2 step_size;
-	int2 _cutoff_frequency;
-	float3 u_axis;
-	float3 v_axis;
-	
-	bool cull_fully_aliased_terms;
-	
-	
-	bool _automatic_d_image;
-
-#ifdef _LIBMESHLESSVIS_USE_CPU
-	fftwf_plan _plan;
-#else
-	cufftHandle _plan;
-#endif
-
-	int2 _number_of_samples;
-	int block_length;
-	float _scale;
-	float* _d_image;
-
-#ifdef _LIBMESHLESSVIS_USE_CPU
-	fftwf_complex* _d_freq_image;
-#else
-	float2* _d_freq_image;
-#endif
-
-	int _number_of_partial_sums;
-
-#ifdef _LIBMESHLESSVIS_USE_CPU
-	fftwf_complex* _d_freq_image_arranged;
-#else
-	float2* _d_freq_image_arranged;
-#endif
-
-	
-} VisConfig;
-
-VisConfig* vis_config_create(bool automatic_d_image, float2 step_size, int2 cutoff_frequency, float3 u_axis, float3 v_axis, int2 number_of_samples, int block_length, int number_of_partial_sums);
-VisConfig* vis_config_get_default();
-bool vis_config_check(VisConfig* vis_config);
-void vis_config_manual_d_image(VisConfig* vis_config, float2* d_image);
-void vis_config_change_number_of_samples(VisConfig* vis_config, int2 number_of_samples);
-void vis_config_change_cutoff_frequency(VisConfig* vis_config, int2 cutoff_frequency);
-void vis_config_change_number_of_partial_sums(VisConfig* vis_config, int number_of_partial_sums);
-void vis_config_destroy(VisConfig* vis_config);
-void vis_config_compute_scale(VisConfig* vis_config);
-void vis_register_meshless_dataset(VisConfig* vis_config, MeshlessDataset* meshless_dataset);
-void vis_unregister_meshless_dataset(VisConfig* vis_config, MeshlessDataset* meshless_dataset);
-void vis_opengl_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config, GLuint buffer_object);
-void vis_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config);
-void vis_copy_to_host(VisConfig* vis_config, float* h_image);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif
+/*
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef MESHLESS_VISh
+#define MESHLESS_VISh
+
+#include "meshless.h"
+#include <vector_functions.h>
+#include <builtin_types.h>
+#include <cufft.h>
+#include <GL/glew.h>
+#include <stddef.h>
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+#include <fftw3.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+enum VisInstructionSet
+{
+	VIS_SCALAR,
+	VIS_AVX2,
+	VIS_AVX512
+};
+
+enum VisSamplingMethod
+{
+	VIS_DIRECT_SUMMATION,	// evaluates sin and cos for every term at every sample
+	VIS_PHASE_RECURRENCE,	// walks each row of samples by rotating every term's phase with a complex multiply
+	VIS_NUFFT,				// spreads the terms onto an oversampled grid and FFTs it, accurate to nufft_tolerance, groups with varying radii are summed directly
+	VIS_SPECTRUM_SLICE,		// interpolates a slice of each group's 3D spectrum, which is computed once and kept while the dataset is registered,
+							// so rotating costs the same for any number of terms.  Also accurate to nufft_tolerance and with the same restriction on radii
+	VIS_HIERARCHICAL		// sums clusters of terms from an octree by their Taylor expansions where the frequency is low enough, and the terms of
+							// the leaves elsewhere, suits highly clustered data.  Also accurate to nufft_tolerance and with the same restriction on radii
+};
+	
+// how thoroughly FFTW plans the image's inverse FFT, see vis_fft_warm_up
+enum VisFFTPlanning
+{
+	VIS_FFT_ESTIMATE,
+	VIS_FFT_MEASURE,
+	VIS_FFT_PATIENT
+};
+
+// what backs the registered terms and the sample and image buffers, arrays smaller than a huge page (2MB) never get them.  Explicit
+// huge pages come from the pool reserved in /proc/sys/vm/nr_hugepages and fall back on transparent ones, both are only used on Linux.
+enum VisHugePages
+{
+	VIS_HUGE_PAGES_NONE,
+	VIS_HUGE_PAGES_TRANSPARENT,
+	VIS_HUGE_PAGES_EXPLICIT
+};
+
+typedef struct 
+{
+	// variables prefixed with an underscore are private and should only be modified a vis_config_< do something > function
+	
+	float2 step_size;
+	int2 _cutoff_frequency;
+	float3 u_axis;
+	float3 v_axis;
+	
+	// skips the terms that lie entirely outside the period of the image centered on the origin, which would only appear as aliases
+	// wrapped around from a neighbouring period.  A term's footprint is its radius around it for WENDLAND_D3_C2 and twice that for SPH,
+	// whose radius is the smoothing length, and GAUSSIAN.  The CPU backend culls for every sampling method but VIS_SPECTRUM_SLICE and
+	// VIS_HIERARCHICAL, the CUDA backend always does.
+	bool cull_fully_aliased_terms;
+	
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	// the widest instruction set the CPU kernels may use, vis_config_create picks the widest one the processor supports
+	VisInstructionSet instruction_set;
+	VisSamplingMethod sampling_method;
+	float nufft_tolerance;	// relative to the sum of the absolute values of the weights, for VIS_NUFFT, VIS_SPECTRUM_SLICE and VIS_HIERARCHICAL
+
+	// 0 evaluates the basis functions' transforms analytically, otherwise they are interpolated from tables accurate to this
+	// (relative to the transform at zero, or to the value itself where that is larger).  The error actually achieved is reported
+	// in _basis_function_table_error.  The tables speed up the scalar kernels, the vectorized ones are usually faster without them.
+	float basis_function_tolerance;
+	float _basis_function_table_error;
+	struct BasisFunctionTable* _basis_function_tables[3];	// indexed by BasisFunctionId
+
+	// the direct summation kernels work through tiles of at least tile_samples samples, tile_terms terms at a time,
+	// which should be few enough for the terms to stay in the L1 or L2 cache while they're reused across the tile
+	int tile_samples;
+	int tile_terms;
+
+	// with fuse_groups direct summation goes over all the groups of a dataset in one pass over the image instead of one pass per group
+	bool fuse_groups;
+
+	// terms whose basis function's transform stays below basis_function_epsilon times its value at zero from a sample outwards are
+	// skipped for that sample, 0 keeps every term.  Worthwhile when the radii vary a lot.
+	float basis_function_epsilon;
+	float _negligible_argument[3];	// indexed by BasisFunctionId, where the transforms drop below basis_function_epsilon for good
+
+	// On a NUMA machine each page lives on the node of the thread that first wrote it.  With _parallel_first_touch the buffers and the
+	// registered terms are first written by the threads that go on to use them, in the kernels' static partition, instead of all by the
+	// calling thread, and with replicate_terms every node gets its own copy of each group's terms at registration.  Both pay off with
+	// pinned threads (see vis_set_thread_affinity).  Set _parallel_first_touch and _huge_pages with vis_config_place_memory.
+	bool _parallel_first_touch;
+	bool replicate_terms;
+	VisHugePages _huge_pages;
+#endif
+	
+	bool _automatic_d_image;
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	// the plans for the inverse FFT come from a cache shared by all configs, see vis_fft_warm_up.  VIS_FFT_MEASURE and VIS_FFT_PATIENT
+	// find faster plans but take much longer to plan a size the first time, unless there is wisdom for it.
+	VisFFTPlanning fft_planning;
+#else
+	cufftHandle _plan;
+#endif
+
+	int2 _number_of_samples;
+	int block_length;
+	float _scale;
+	float* _d_image;
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	fftwf_complex* _d_freq_image;		// not allocated when _arrange_samples_in_kernels is set
+	// the sampling kernels write straight into _d_freq_image_arranged instead of _d_freq_image, saving arrange_samples' pass
+	// over the samples, set it with vis_config_arrange_samples_in_kernels
+	bool _arrange_samples_in_kernels;
+#else
+	float2* _d_freq_image;
+#endif
+
+	// the CPU backend splits the terms into this many partitions for the direct summation kernels, 0 picks as many as the number of
+	// threads and tiles of samples call for (see work_stealing_cpu.h)
+	int _number_of_partial_sums;
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	fftwf_complex* _d_freq_image_arranged;
+#else
+	float2* _d_freq_image_arranged;
+#endif
+
+	
+} VisConfig;
+
+// Thread safety of the CPU library: different configs may be created, changed, rendered with and destroyed from different threads at
+// the same time, but each config must only be used by one thread at a time.  A dataset is registered and unregistered through one
+// config while no config is rendering it, and in between any number of configs may render it concurrently, as they may a registration
+// (retaining and releasing registrations is thread-safe, the last release must not race a render of it).  Concurrent renders
+// started from the threads of an OpenMP parallel region only get threads of their own with nested parallelism enabled (omp_set_nested),
+// otherwise each runs on its calling thread alone.
+VisConfig* vis_config_create(bool automatic_d_image, float2 step_size, int2 cutoff_frequency, float3 u_axis, float3 v_axis, int2 number_of_samples, int block_length, int number_of_partial_sums);
+VisConfig* vis_config_get_default();
+bool vis_config_check(VisConfig* vis_config);
+void vis_config_manual_d_image(VisConfig* vis_config, float2* d_image);
+void vis_config_change_number_of_samples(VisConfig* vis_config, int2 number_of_samples);
+void vis_config_change_cutoff_frequency(VisConfig* vis_config, int2 cutoff_frequency);
+void vis_config_change_number_of_partial_sums(VisConfig* vis_config, int number_of_partial_sums);
+void vis_config_destroy(VisConfig* vis_config);
+void vis_config_compute_scale(VisConfig* vis_config);
+void vis_register_meshless_dataset(VisConfig* vis_config, MeshlessDataset* meshless_dataset);
+void vis_unregister_meshless_dataset(VisConfig* vis_config, MeshlessDataset* meshless_dataset);
+void vis_opengl_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config, GLuint buffer_object);
+void vis_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config);
+void vis_copy_to_host(VisConfig* vis_config, float* h_image);
+
+// A registration holds its own prepared copy of a dataset's terms, leaving the dataset's groups untouched, so one registration can be
+// shared by any number of configs instead of the dataset being registered with each.  The dataset's host arrays are only read while
+// creating it (on the CPU).  It starts with one reference and is freed when the last one is released.  A config can render it if
+// vis_registration_is_compatible, which with the CUDA backend needs the config's padding (block_length times _number_of_partial_sums)
+// to divide the padding it was created with, and always holds on the CPU.  Of the creating config the CUDA backend keeps that padding,
+// the CPU backend only replicate_terms, _huge_pages and _parallel_first_touch, which place the copy of the terms, and block_length,
+// which they're padded to.  Nothing depends on its sampling method, the spectrum and octree are built by the first config to use them.
+typedef struct VisRegistration VisRegistration;
+VisRegistration* vis_registration_create(VisConfig* vis_config, MeshlessDataset* meshless_dataset);
+void vis_registration_retain(VisRegistration* registration);
+void vis_registration_release(VisRegistration* registration);
+bool vis_registration_is_compatible(VisRegistration* registration, VisConfig* vis_config);
+void vis_registration_fourier_volume_rendering(VisRegistration* registration, VisConfig* vis_config);
+void vis_registration_opengl_fourier_volume_rendering(VisRegistration* registration, VisConfig* vis_config, GLuint buffer_object);
+size_t vis_registration_size(VisRegistration* registration);	// in bytes, of the copy of the terms and the spectra and octrees built so far
+
+// Keeps the registrations of recently rendered datasets, so that coming back to a dataset (the timesteps of a looping animation, say)
+// doesn't register it again.  A dataset is identified by its groups array and its generation, which must be bumped whenever its host
+// data changes.  Once the registrations' sizes add up to more than budget bytes the least recently used ones are released, but never
+// the one just asked for.  The sizes are taken again on every get, since rendering a registration may have grown it.  Forget a
+// dataset before deleting it, another could be allocated at the same address.  Thread-safe.
+typedef struct VisRegistrationCache VisRegistrationCache;
+VisRegistrationCache* vis_registration_cache_create(size_t budget);
+void vis_registration_cache_destroy(VisRegistrationCache* cache);
+
+// returns a registration of the dataset's current generation that the config can render, registering it through the config if there
+// is none, with a reference the caller releases when it's done rendering
+VisRegistration* vis_registration_cache_get(VisRegistrationCache* cache, VisConfig* vis_config, MeshlessDataset* meshless_dataset);
+void vis_registration_cache_forget(VisRegistrationCache* cache, MeshlessDataset* meshless_dataset);
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+VisInstructionSet vis_get_supported_instruction_set();
+
+// The CPU kernels and the FFTs all run on the OpenMP worker pool of the thread that calls the library, one after another.  These set
+// how many threads they use (0 for omp_get_max_threads(), the default) and pin the pool's threads, the calling thread included, to
+// processors: thread i to processors[i % number_of_processors], or unpins them given no processors.  They apply to every config
+// and must not be called while one is rendering.
+void vis_set_number_of_threads(int number_of_threads);
+int vis_get_number_of_threads();
+bool vis_set_thread_affinity(const int* processors, int number_of_processors);
+void vis_config_arrange_samples_in_kernels(VisConfig* vis_config, bool arrange_samples_in_kernels);
+
+// Renders a dataset too large to register whole, without registering it: the terms of each group are registered chunk_terms at a
+// time, each chunk's samples added to the ones before and the chunk unregistered again, so that besides the samples and the image
+// only one chunk's copy of the terms is held.  For a dataset loaded with load_meshless_datasets_from_binary_file the host arrays
+// stay in the mapped file and the next chunk is read in while one is summed (see meshless_dataset_prefetch_terms), so don't shift
+// such a dataset, that makes a private copy of every page.  The transform is linear in the terms, so the
+// image is the one vis_fourier_volume_rendering renders, up to rounding and the tolerances of the methods, except that
+// VIS_SPECTRUM_SLICE and VIS_HIERARCHICAL rebuild their structures for every chunk, which seldom pays off.
+void vis_out_of_core_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config, int chunk_terms);
+
+// reallocates the sample and image buffers with this placement, datasets registered afterwards get it too
+void vis_config_place_memory(VisConfig* vis_config, bool parallel_first_touch, VisHugePages huge_pages);
+
+// Plans the inverse FFT for configs of this size ahead of time, so that creating or resizing them later finds the plans in the cache.
+// FFTW's wisdom remembers the best plans it has measured, and saved to a file and imported at the next start, it makes measured
+// plans cheap to remake.  The plans and wisdom are shared by every config, and these may be called from any thread while others
+// render.  FFTW's threads are cleaned up, which forgets the wisdom, once the last config is destroyed and the plans forgotten.
+void vis_fft_warm_up(int2 number_of_samples, int2 cutoff_frequency, VisFFTPlanning fft_planning);
+bool vis_fft_import_wisdom(const char* filename);
+bool vis_fft_export_wisdom(const char* filename);
+void vis_fft_forget_plans();	// destroys the cached plans, no config may be rendering
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+/*
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+
+#include "meshless.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+
+static bool ends_with(const std::string& s, const char* suffix)
+{
+	const size_t n = std::strlen(suffix);
+	return s.size() >= n && s.compare(s.size()-n, n, suffix) == 0;
+}
+
+// Converts between the text (.sph), binary (.sphb) and compressed (.sphz) formats of meshless.h.  The input may be in any of them,
+// the output is written in the format its extension names, or the one --text, --binary or --compressed asks for, which an output with
+// another extension needs.  Compression keeps --position-bits bits per coordinate (16 by default) and a keyframe every
+// --keyframe-interval timesteps (16 by default).
+int main(int argc, char** argv)
+{
+	enum {DEFAULT, TEXT, BINARY, COMPRESSED} format = DEFAULT;
+	int position_bits = 16, keyframe_interval = 16;
+	const char* filenames[2] = {0, 0};
+	int number_of_filenames = 0;
+	bool valid = true;
+	for(int i = 1; i != argc; i++)
+	{
+		if(std::strcmp(argv[i], "--text") == 0 || std::strcmp(argv[i], "--binary") == 0 || std::strcmp(argv[i], "--compressed") == 0)
+		{
+			valid = valid && format == DEFAULT;
+			format = argv[i][2] == 't' ? TEXT : argv[i][2] == 'b' ? BINARY : COMPRESSED;
+		}
+		else if(std::strcmp(argv[i], "--position-bits") == 0 && i+1 != argc) position_bits = std::atoi(argv[++i]);
+		else if(std::strcmp(argv[i], "--keyframe-interval") == 0 && i+1 != argc) keyframe_interval = std::atoi(argv[++i]);
+		else if(number_of_filenames != 2) filenames[number_of_filenames++] = argv[i];
+		else valid = false;
+	}
+	if(!valid || number_of_filenames != 2 || position_bits < 1 || position_bits > 24 || keyframe_interval < 1)
+	{
+		std::cerr << "usage: " << argv[0] << " [--text | --binary | --compressed] [--position-bits 1-24] [--keyframe-interval n] input output" << std::endl;
+		return 1;
+	}
+	if(format == DEFAULT)
+	{
+		if(ends_with(filenames[1], ".sph"))       format = TEXT;
+		else if(ends_with(filenames[1], ".sphb")) format = BINARY;
+		else if(ends_with(filenames[1], ".sphz")) format = COMPRESSED;
+		else
+		{
+			std::cerr << "name the output .sph, .sphb or .sphz, or give its format" << std::endl;
+			return 1;
+		}
+	}
+
+	MeshlessDataset* meshless_datasets;
+	int number_of_datasets;
+	bool loaded = true;
+	if(is_binary_meshless_file(filenames[0])) loaded = load_meshless_datasets_from_binary_file(filenames[0], &meshless_datasets, &number_of_datasets);
+	else if(is_compressed_meshless_file(filenames[0])) loaded = load_meshless_datasets_from_compressed_file(filenames[0], &meshless_datasets, &number_of_datasets);
+	else load_meshless_datasets_from_file(filenames[0], &meshless_datasets, &number_of_datasets);
+	if(!loaded)
+	{
+		std::cerr << "invalid dataset file " << filenames[0] << std::endl;
+		return 1;
+	}
+
+	long long number_of_terms = 0;
+	for(int i = 0; i != number_of_datasets; i++) number_of_terms += get_number_of_terms(meshless_datasets+i);
+
+	bool saved = true;
+	float position_error = 0.0f;
+	if(format == TEXT) save_meshless_datasets_to_file(filenames[1], meshless_datasets, number_of_datasets);
+	else if(format == BINARY) saved = save_meshless_datasets_to_binary_file(filenames[1], meshless_datasets, number_of_datasets);
+	else saved = save_meshless_datasets_to_compressed_file(filenames[1], meshless_datasets, number_of_datasets, position_bits, keyframe_interval, &position_error);
+	delete_meshless_datasets(meshless_datasets, number_of_datasets);
+
+	if(!saved)
+	{
+		std::cerr << "couldn't write " << filenames[1] << std::endl;
+		return 1;
+	}
+	const char* format_names[] = {"", "text", "binary", "compressed"};
+	std::cout << "wrote " << number_of_datasets << " timesteps, " << number_of_terms << " terms to " << filenames[1] << " as " << format_names[format] << std::endl;
+	if(format == COMPRESSED) std::cout << "largest position error " << position_error << std::endl;
+	return 0;
+}
@@ -0,0 +1,179 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "entropy_coding.h"
+#include <algorithm>
+#include <cstring>
+
+enum EntropyCodingMode
+{
+	SINGLE_VALUE,
+	STORED,
+	RANS
+};
+
+// the frequencies of the bytes are scaled to sum to 1 << rans_scale_bits, the state is kept in [rans_lower_bound, rans_lower_bound << 8)
+static const int rans_scale_bits = 12;
+static const unsigned int rans_scale = 1u << rans_scale_bits;
+static const unsigned int rans_lower_bound = 1u << 23;
+
+// scales the counts of the bytes to frequencies summing to rans_scale, keeping every byte that occurs at least 1
+static void normalize_frequencies(const size_t counts[256], size_t size, unsigned int frequencies[256])
+{
+	unsigned int sum = 0;
+	int largest = 0;
+	for(int s = 0; s != 256; s++)
+	{
+		frequencies[s] = counts[s] == 0 ? 0 : std::max(1u, (unsigned int)((double)counts[s] * rans_scale / size));
+		sum += frequencies[s];
+		if(counts[s] > counts[largest]) largest = s;
+	}
+	// rounding is off by at most one per byte value, which the most frequent byte nearly always absorbs
+	while(sum > rans_scale)
+	{
+		int s = largest;
+		if(frequencies[s] <= sum - rans_scale) s = (int)(std::max_element(frequencies, frequencies + 256) - frequencies);
+		const unsigned int decrease = std::min(sum - rans_scale, frequencies[s] - 1);
+		frequencies[s] -= decrease;
+		sum -= decrease;
+	}
+	frequencies[largest] += rans_scale - sum;
+}
+
+static void write_uint32(unsigned char* p, unsigned int value)
+{
+	for(int i = 0; i != 4; i++) p[i] = (unsigned char)(value >> (8*i));
+}
+
+static unsigned int read_uint32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+void entropy_encode(const unsigned char* data, size_t size, std::vector<unsigned char>& coded)
+{
+	size_t counts[256] = {0};
+	for(size_t i = 0; i != size; i++) counts[data[i]]++;
+
+	if(size == 0 || counts[data[0]] == size)
+	{
+		coded.push_back(SINGLE_VALUE);
+		coded.push_back(size == 0 ? 0 : data[0]);
+		return;
+	}
+
+	unsigned int frequencies[256], cumulative[257];
+	normalize_frequencies(counts, size, frequencies);
+	cumulative[0] = 0;
+	for(int s = 0; s != 256; s++) cumulative[s+1] = cumulative[s] + frequencies[s];
+
+	// rANS codes backwards, so the output is written from the end of a buffer large enough for any input
+	std::vector<unsigned char> buffer(2*size + 16);
+	unsigned char* end = &buffer[0] + buffer.size();
+	unsigned char* p = end;
+	unsigned int state = rans_lower_bound;
+	for(size_t i = size; i-- != 0;)
+	{
+		const unsigned int frequency = frequencies[data[i]];
+		const unsigned int state_limit = ((rans_lower_bound >> rans_scale_bits) << 8) * frequency;
+		while(state >= state_limit)
+		{
+			*--p = (unsigned char)state;
+			state >>= 8;
+		}
+		state = ((state / frequency) << rans_scale_bits) + state % frequency + cumulative[data[i]];
+	}
+	p -= 4;
+	write_uint32(p, state);
+
+	const size_t rans_size = 1 + 2*256 + 4 + (end - p);
+	if(rans_size >= 1 + size)
+	{
+		coded.push_back(STORED);
+		coded.insert(coded.end(), data, data + size);
+		return;
+	}
+	coded.push_back(RANS);
+	for(int s = 0; s != 256; s++)
+	{
+		coded.push_back((unsigned char)frequencies[s]);
+		coded.push_back((unsigned char)(frequencies[s] >> 8));
+	}
+	unsigned char length[4];
+	write_uint32(length, (unsigned int)(end - p));
+	coded.insert(coded.end(), length, length + 4);
+	coded.insert(coded.end(), p, end);
+}
+
+const unsigned char* entropy_decode(const unsigned char* coded, const unsigned char* coded_end, unsigned char* data, size_t size)
+{
+	if(coded_end - coded < 2) return 0;
+	switch(*coded++)
+	{
+	case SINGLE_VALUE:
+		std::memset(data, *coded, size);
+		return coded + 1;
+
+	case STORED:
+		if((size_t)(coded_end - coded) < size) return 0;
+		std::memcpy(data, coded, size);
+		return coded + size;
+
+	case RANS:
+	{
+		if(coded_end - coded < 2*256 + 4) return 0;
+		unsigned int frequencies[256], cumulative[257];
+		cumulative[0] = 0;
+		for(int s = 0; s != 256; s++)
+		{
+			frequencies[s] = coded[2*s] | (coded[2*s+1] << 8);
+			cumulative[s+1] = cumulative[s] + frequencies[s];
+		}
+		if(cumulative[256] != rans_scale) return 0;
+		const size_t length = read_uint32(coded + 2*256);
+		coded += 2*256 + 4;
+		if(length < 4 || (size_t)(coded_end - coded) < length) return 0;
+		const unsigned char* end = coded + length;
+
+		unsigned char symbols[rans_scale];
+		for(int s = 0; s != 256; s++) std::memset(symbols + cumulative[s], s, frequencies[s]);
+
+		unsigned int state = read_uint32(coded);
+		const unsigned char* p = coded + 4;
+		for(size_t i = 0; i != size; i++)
+		{
+			const unsigned int slot = state & (rans_scale-1);
+			const unsigned char s = symbols[slot];
+			data[i] = s;
+			state = frequencies[s] * (state >> rans_scale_bits) + slot - cumulative[s];
+			while(state < rans_lower_bound)
+			{
+				if(p == end) return 0;
+				state = (state << 8) | *p++;
+			}
+		}
+		return end;
+	}
+
+	default:
+		return 0;
+	}
+}
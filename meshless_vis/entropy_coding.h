@@ -0,0 +1,38 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef ENTROPY_CODING_H_
+#define ENTROPY_CODING_H_
+
+#include <vector>
+#include <cstddef>
+
+// Order-0 entropy coding of byte arrays with rANS, for the compressed dataset format.  Arrays made up of a single byte value are coded
+// as that value, and ones rANS wouldn't make smaller are stored as they are.  Each array is coded on its own, so different arrays can
+// be coded and decoded by different threads.
+
+// appends the coded data to coded
+void entropy_encode(const unsigned char* data, size_t size, std::vector<unsigned char>& coded);
+
+// decodes size bytes from the coded data starting at coded, returns the end of the coded data or 0 if it isn't valid
+const unsigned char* entropy_decode(const unsigned char* coded, const unsigned char* coded_end, unsigned char* data, size_t size);
+
+#endif /*ENTROPY_CODING_H_*/
@@ -0,0 +1,225 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "fft_plans_cpu.h"
+
+#include <map>
+#include <vector>
+
+// The column transform is planned for cutoff_frequency.y rounded up to a multiple of this many columns, so that changing the cutoff
+// frequency only needs a new plan every so often.  The extra columns are beyond the cutoff and so zero, which the transform leaves zero.
+const int fft_column_granularity = 8;
+
+struct FFTPlanKey
+{
+	int nx, ny, number_of_columns, threads;
+	// fftwf_alignment_of _d_freq_image_arranged and of _d_image, the plans are only valid for arrays aligned the same way
+	int arranged_alignment, image_alignment;
+
+	bool operator<(const FFTPlanKey& b) const
+	{
+		if(nx != b.nx) return nx < b.nx;
+		if(ny != b.ny) return ny < b.ny;
+		if(number_of_columns != b.number_of_columns) return number_of_columns < b.number_of_columns;
+		if(threads != b.threads) return threads < b.threads;
+		if(arranged_alignment != b.arranged_alignment) return arranged_alignment < b.arranged_alignment;
+		return image_alignment < b.image_alignment;
+	}
+};
+
+// FFTW's planner (making and destroying plans, wisdom, fftwf_init_threads and fftwf_cleanup_threads) isn't thread-safe, so everything
+// here that calls it runs in the critical section fft_planner, which also guards the cache.  Executing plans is thread-safe.
+typedef std::map<FFTPlanKey, FFTPlans> FFTPlanCache;
+static FFTPlanCache fft_plan_cache;
+static std::vector<FFTPlans> retired_fft_plans;	// replaced by more thoroughly planned ones, but maybe still running in another thread
+
+// FFTW's threads are set up for the first config or plan and cleaned up once the last config is destroyed and the plans are forgotten,
+// fftwf_cleanup_threads invalidates every plan and forgets the wisdom
+static bool fft_threads_initialized = false;
+static int fft_threads_users = 0;
+
+static void initialize_fft_threads()
+{
+	if(!fft_threads_initialized) fftwf_init_threads(), fft_threads_initialized = true;
+}
+
+static void cleanup_fft_threads_if_unused()
+{
+	if(fft_threads_initialized && fft_threads_users == 0 && fft_plan_cache.empty() && retired_fft_plans.empty())
+	{
+		fftwf_cleanup_threads();
+		fft_threads_initialized = false;
+	}
+}
+
+static void destroy(const FFTPlans& plans)
+{
+	fftwf_destroy_plan(plans.columns);
+	fftwf_destroy_plan(plans.rows);
+}
+
+static unsigned planner_flags(VisFFTPlanning planning)
+{
+	if(planning == VIS_FFT_PATIENT) return FFTW_PATIENT;
+	if(planning == VIS_FFT_MEASURE) return FFTW_MEASURE;
+	return FFTW_ESTIMATE;
+}
+
+// Measuring plans runs them on their arrays, so they're planned on scratch arrays offset to the same alignment as the config's.
+// fftwf_malloc aligns to FFTW's widest SIMD, so the offsets are the alignments themselves.
+static FFTPlans plan(const FFTPlanKey& key, VisFFTPlanning planning)
+{
+	initialize_fft_threads();
+	fftwf_plan_with_nthreads(key.threads);
+
+	int row_length = key.ny/2+1;
+	char* input = (char*)fftwf_malloc(sizeof(fftwf_complex)*key.nx*row_length + key.arranged_alignment);
+	char* output = (char*)fftwf_malloc(sizeof(float)*key.nx*key.ny + key.image_alignment);
+	fftwf_complex* arranged = (fftwf_complex*)(input + key.arranged_alignment);
+	float* image = (float*)(output + key.image_alignment);
+
+	FFTPlans plans;
+	plans.number_of_columns = key.number_of_columns;
+	plans.planning = planning;
+	plans.columns = fftwf_plan_many_dft(1, &key.nx, key.number_of_columns, arranged, 0, row_length, 1, arranged, 0, row_length, 1, FFTW_BACKWARD, planner_flags(planning));
+	plans.rows = fftwf_plan_many_dft_c2r(1, &key.ny, key.nx, arranged, 0, 1, row_length, image, 0, 1, key.ny, planner_flags(planning) | FFTW_PRESERVE_INPUT);
+
+	fftwf_free(input);
+	fftwf_free(output);
+	return plans;
+}
+
+static FFTPlanKey make_key(int2 number_of_samples, int cutoff_frequency_y, int threads, int arranged_alignment, int image_alignment)
+{
+	FFTPlanKey key;
+	key.nx = number_of_samples.x, key.ny = number_of_samples.y, key.threads = threads;
+	key.arranged_alignment = arranged_alignment, key.image_alignment = image_alignment;
+	key.number_of_columns = fft_column_granularity*((cutoff_frequency_y + fft_column_granularity - 1)/fft_column_granularity);
+	if(key.number_of_columns > key.ny/2+1) key.number_of_columns = key.ny/2+1;
+	return key;
+}
+
+static FFTPlans get(const FFTPlanKey& key, VisFFTPlanning planning)
+{
+	FFTPlans plans;
+	#pragma omp critical(fft_planner)
+	{
+		FFTPlanCache::iterator found = fft_plan_cache.find(key);
+		if(found != fft_plan_cache.end() && found->second.planning < planning)
+		{
+			retired_fft_plans.push_back(found->second);
+			fft_plan_cache.erase(found);
+			found = fft_plan_cache.end();
+		}
+		if(found == fft_plan_cache.end()) found = fft_plan_cache.insert(std::make_pair(key, plan(key, planning))).first;
+		plans = found->second;
+	}
+	return plans;
+}
+
+FFTPlans fft_plans_get(VisConfig* vis_config)
+{
+	int arranged_alignment = fftwf_alignment_of((float*)vis_config->_d_freq_image_arranged), image_alignment = fftwf_alignment_of(vis_config->_d_image);
+	FFTPlanKey key = make_key(vis_config->_number_of_samples, vis_config->_cutoff_frequency.y, vis_get_number_of_threads(), arranged_alignment, image_alignment);
+	return get(key, vis_config->fft_planning);
+}
+
+void vis_fft_warm_up(int2 number_of_samples, int2 cutoff_frequency, VisFFTPlanning fft_planning)
+{
+	// for arrays from fftwf_malloc, as VisConfig allocates them
+	get(make_key(number_of_samples, cutoff_frequency.y, vis_get_number_of_threads(), 0, 0), fft_planning);
+}
+
+void fft_threads_acquire()
+{
+	#pragma omp critical(fft_planner)
+	{
+		initialize_fft_threads();
+		fft_threads_users++;
+	}
+}
+
+void fft_threads_release()
+{
+	#pragma omp critical(fft_planner)
+	{
+		fft_threads_users--;
+		cleanup_fft_threads_if_unused();
+	}
+}
+
+fftwf_plan fft_plan_dft_2d(int n0, int n1, fftwf_complex* data, int sign)
+{
+	fftwf_plan plan;
+	#pragma omp critical(fft_planner)
+	{
+		initialize_fft_threads();
+		fftwf_plan_with_nthreads(vis_get_number_of_threads());
+		plan = fftwf_plan_dft_2d(n0, n1, data, data, sign, FFTW_ESTIMATE);
+	}
+	return plan;
+}
+
+fftwf_plan fft_plan_dft_r2c_3d(int n0, int n1, int n2, float* data)
+{
+	fftwf_plan plan;
+	#pragma omp critical(fft_planner)
+	{
+		initialize_fft_threads();
+		fftwf_plan_with_nthreads(vis_get_number_of_threads());
+		plan = fftwf_plan_dft_r2c_3d(n0, n1, n2, data, (fftwf_complex*)data, FFTW_ESTIMATE);
+	}
+	return plan;
+}
+
+void fft_destroy_plan(fftwf_plan plan)
+{
+	#pragma omp critical(fft_planner)
+	fftwf_destroy_plan(plan);
+}
+
+bool vis_fft_import_wisdom(const char* filename)
+{
+	bool imported;
+	#pragma omp critical(fft_planner)
+	imported = fftwf_import_wisdom_from_filename(filename) != 0;
+	return imported;
+}
+
+bool vis_fft_export_wisdom(const char* filename)
+{
+	bool exported;
+	#pragma omp critical(fft_planner)
+	exported = fftwf_export_wisdom_to_filename(filename) != 0;
+	return exported;
+}
+
+void vis_fft_forget_plans()
+{
+	#pragma omp critical(fft_planner)
+	{
+		for(FFTPlanCache::iterator i = fft_plan_cache.begin(); i != fft_plan_cache.end(); ++i) destroy(i->second);
+		for(size_t i = 0; i != retired_fft_plans.size(); i++) destroy(retired_fft_plans[i]);
+		fft_plan_cache.clear();
+		retired_fft_plans.clear();
+		cleanup_fft_threads_if_unused();
+	}
+}
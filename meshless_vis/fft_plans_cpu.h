@@ -0,0 +1,52 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FFT_PLANS_CPU_H_
+#define FFT_PLANS_CPU_H_
+
+#include "meshless_vis.h"
+
+// The inverse FFT of _d_freq_image_arranged into _d_image runs two plans (see create_plans in meshless_vis_cpu.cpp): an in-place
+// transform down the columns below the cutoff frequency and a C2R along every row.  The plans are kept in a cache shared by every
+// VisConfig and executed on each config's own arrays, so a size only has to be planned once per process, and with wisdom only once.
+struct FFTPlans
+{
+	fftwf_plan columns, rows;
+	int number_of_columns;		// the column transform covers this many columns, at least cutoff_frequency.y
+	VisFFTPlanning planning;
+};
+
+// finds or plans the transforms for the config's arrays and sizes and vis_get_number_of_threads(), replanning if the cached ones were planned
+// less thoroughly than vis_config->fft_planning asks for.  The plans are returned by value, another config replanning them replaces the
+// cache's entry, but the plans themselves stay alive until vis_fft_forget_plans.
+FFTPlans fft_plans_get(VisConfig* vis_config);
+
+// every config holds FFTW's threads from vis_config_create to vis_config_destroy, see fft_plans_cpu.cpp
+void fft_threads_acquire();
+void fft_threads_release();
+
+// the other transforms of the library (see fourier_transform_nufft_cpu.cpp) are planned and destroyed with these, which take turns
+// with every other use of FFTW's planner, for vis_get_number_of_threads() threads
+fftwf_plan fft_plan_dft_2d(int n0, int n1, fftwf_complex* data, int sign);
+fftwf_plan fft_plan_dft_r2c_3d(int n0, int n1, int n2, float* data);
+void fft_destroy_plan(fftwf_plan plan);
+
+#endif /*FFT_PLANS_CPU_H_*/
@@ -1,36 +1,41 @@
-//
-//Warning: This file was automatically generated by fourier_transform_generate.py
-//         Do not edit it!
-//
-
-/*
-
-libMeshlessVis
-Copyright (C) 2008 Andrew Corrigan
-
-This program is free software; you can redistribute it and/or
-modify it under the terms of the GNU General Public License
-as published by the Free Software Foundation; either version 2
-of the License, or (at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program; if not, write to the Free Software
-Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
-
-*/
-
-#ifndef FOURIER_TRANSFORM_H_
-#define FOURIER_TRANSFORM_H_
-
-#include "meshless_vis.h"
-#include "meshless.h"
-
-void fourier_transform(MeshlessDataset* meshless_dataset, VisConfig* vis_config);
-
-
-#endif /*FOURIER_TRANSFORM_H_*/
+//
+//Warning: This file was automatically generated by fourier_transform_generate.py
+//         Do not edit it!
+//
+
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FOURIER_TRANSFORM_H_
+#define FOURIER_TRANSFORM_H_
+
+#include "meshless_vis.h"
+#include "meshless.h"
+
+void fourier_transform(MeshlessDataset* meshless_dataset, VisConfig* vis_config);
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+// adds the dataset's samples to the ones already there instead of replacing them
+void fourier_transform_accumulate(MeshlessDataset* meshless_dataset, VisConfig* vis_config);
+#endif
+
+
+#endif /*FOURIER_TRANSFORM_H_*/
@@ -0,0 +1,33 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// compiled with -mavx512f -mfma, see makefile_cpu
+
+#include "fourier_transform_simd_cpu.h"
+
+#ifdef MESHLESS_VIS_HAVE_X86_SIMD
+
+#define MESHLESS_VIS_SIMD_WIDTH 16
+#define MESHLESS_VIS_SIMD_ENTRY sample_fourier_transform_over_grid_avx512
+#define MESHLESS_VIS_SIMD_FUSED_ENTRY sample_fourier_transform_over_grid_fused_avx512
+#include "fourier_transform_simd_cpu.inl"
+
+#endif
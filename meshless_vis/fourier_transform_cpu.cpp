@@ -1,171 +1,1020 @@
-/*
-
-libMeshlessVis
-Copyright (C) 2008 Andrew Corrigan
-
-This program is free software; you can redistribute it and/or
-modify it under the terms of the GNU General Public License
-as published by the Free Software Foundation; either version 2
-of the License, or (at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program; if not, write to the Free Software
-Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
-
-*/
-
-#include "fourier_transform_cpu.h"
-#include <cmath>
-#include <iostream>
-
-#ifndef PI_F
-#define PI_F  3.141592653589793238462643383279f
-#endif
-
-#ifndef _2PI_F
-#define _2PI_F 6.283185307179586476925286766559f
-#endif
-
-inline void complex_assign(fftwf_complex& l, const float real, const float imag) { l[0] = real, l[1] = imag; }
-inline void complex_accumulate(fftwf_complex& l, const float real, const float imag) { l[0] += real, l[1] += imag; }
-
-inline float fourier_transform_sph(float r)
-{
-	if(r >= 0.06f) 
-	{
-		float m = PI_F*r;
-		float _2_m = 2.0f*m;
-		float cos_2_m = std::cos(_2_m), sin_2_m = std::sin(_2_m);
-		return ((2.3561944901923448f)/(m*m*m*m*m*m))*(cos_2_m-1.0f)*(cos_2_m+m*sin_2_m-1.0f);		// computing m**6 this way is much faster than pow(m,6)
-	}
-	return (PI_F + r*(-0.007968913156311f + r*(-18.293608272337678f)));		// a quadratic interpolant, note that PI_F is the value at zero
-}
-
-inline float fourier_transform_gaussian(float r)
-{
-	return std::exp(PI_F*r*r);
-}
-
-inline float fourier_transform_wendland_d3_c2(float r)
-{
-	if(r >= 0.24f) 
-	{
-		float m = PI_F*r;
-		float _2_m = 2.0f*m;
-		float cos_2_m = std::cos(_2_m), sin_2_m = std::sin(_2_m);
-		float m_2 = m*m;
-		float m_4 = m_2*m_2;
-		return ((PI_F*7.5f)/(m_4*m_4))*(4.0f*m_2 - 6.0f + (6.0f-m_2)*cos_2_m+4.5f*m*sin_2_m);
-	}
-	return 0.299199300341890f + r*(-0.002379178586124f + r*(-0.370530218163545f));
-}
-
-inline float dot(float3 a, float3 b)
-{
-	return a.x*b.x + a.y*b.y + a.z*b.z;
-}
-
-template <int block_length, bool is_first_group, BasisFunctionId basis_function_id, bool has_radii>
-void sample_fourier_transform_over_grid(int d_number_of_terms, float* d_radii, Constraint* d_constraints, VisConfig vis_config)
-{
-	int index, k, x, y;
-	float fu, fv, r, r0, v, term;
-	float3 f_coord;
-	Constraint constraint;
-	float2 sum;
-	int image_size = 2*vis_config._cutoff_frequency.x*vis_config._cutoff_frequency.y;
-
-	#pragma omp parallel default(shared) private(index, k, x, y, fu, fv, r, r0, v, term, f_coord, constraint, sum)
-	{
-		#pragma omp for schedule(dynamic,block_length) nowait
-		for(index = 0; index < image_size; index++)
-		{
-			x = index % (2*vis_config._cutoff_frequency.x);
-			if(x > vis_config._cutoff_frequency.x) x = x-(2*vis_config._cutoff_frequency.x);
-			y = (index % image_size) / (2*vis_config._cutoff_frequency.x);
-	
-			// compute the image space coordinates
-			fu = vis_config.step_size.x*x, fv = vis_config.step_size.y*y;
-			
-			// map from image space into frequency space
-			f_coord = make_float3(fu*vis_config.u_axis.x + fv*vis_config.v_axis.x, fu*vis_config.u_axis.y + fv*vis_config.v_axis.y, fu*vis_config.u_axis.z + fv*vis_config.v_axis.z);
-		
-			// we don't use the fast sqrt since it's only computed once
-			r = sqrtf((float)(fu*fu + fv*fv));
-		
-			// begin the loop
-			sum = make_float2(0.0f, 0.0f);
-			for(k = 0; k < d_number_of_terms; k++) 
-			{
-				constraint = d_constraints[k];
-				if(has_radii)
-				{
-					r0 = d_radii[k];
-					if     (basis_function_id == SPH)            term = fourier_transform_sph(r*r0);
-					else if(basis_function_id == GAUSSIAN)       term = fourier_transform_gaussian(r*r0);
-					else if(basis_function_id == WENDLAND_D3_C2) term = fourier_transform_wendland_d3_c2(r*r0);
-				}
-				else
-				{
-					if     (basis_function_id == SPH)            term = fourier_transform_sph(r);
-					else if(basis_function_id == GAUSSIAN)       term = fourier_transform_gaussian(r);
-					else if(basis_function_id == WENDLAND_D3_C2) term = fourier_transform_wendland_d3_c2(r);
-				}
-				v = _2PI_F*dot(f_coord, constraint.position);
-				sum.x += constraint.weight*term*std::cos(v);
-				sum.y += constraint.weight*term*std::sin(v);
-			}			
-			
-			if(is_first_group)
-			{
-				 complex_assign(vis_config._d_freq_image[index], sum.x*vis_config._scale, -sum.y*vis_config._scale);
-			}
-			else
-			{
-				complex_accumulate(vis_config._d_freq_image[index], sum.x*vis_config._scale, -sum.y*vis_config._scale);
-			}
-		}
-	}
-}
-
-template <int block_length, bool is_first_group, BasisFunctionId basis_function_id>
-void fourier_transform_level_2(Group* group, VisConfig* vis_config)
-{
-	if(group->d_radii) sample_fourier_transform_over_grid <block_length, is_first_group, basis_function_id, true>  (group->d_number_of_terms, group->d_radii, group->d_constraints, *vis_config);
-	else               sample_fourier_transform_over_grid <block_length, is_first_group, basis_function_id, false> (group->d_number_of_terms, group->d_radii, group->d_constraints, *vis_config);
-}
-
-template <int block_length, bool is_first_group>
-void fourier_transform_level_1(Group* group, VisConfig* vis_config)
-{
-	if     (group->basis_function_id == SPH)            fourier_transform_level_2 <block_length, is_first_group, SPH>            (group, vis_config);
-	else if(group->basis_function_id == GAUSSIAN)       fourier_transform_level_2 <block_length, is_first_group, GAUSSIAN>       (group, vis_config);
-	else if(group->basis_function_id == WENDLAND_D3_C2) fourier_transform_level_2 <block_length, is_first_group, WENDLAND_D3_C2> (group, vis_config);
-}
-
-void fourier_transform(MeshlessDataset* meshless_dataset, VisConfig* vis_config)
-{
-	if (meshless_dataset->number_of_groups < 1) return;
-
-	vis_config_compute_scale(vis_config);
-
-	if     (vis_config->block_length == 512) fourier_transform_level_1 <512, true> (meshless_dataset->groups, vis_config);
-	else if(vis_config->block_length == 256) fourier_transform_level_1 <256, true> (meshless_dataset->groups, vis_config);
-	else if(vis_config->block_length == 128) fourier_transform_level_1 <128, true> (meshless_dataset->groups, vis_config);
-	else if(vis_config->block_length ==  64) fourier_transform_level_1 < 64, true> (meshless_dataset->groups, vis_config);
-	else if(vis_config->block_length ==  32) fourier_transform_level_1 < 32, true> (meshless_dataset->groups, vis_config);
-
-	for(int i = 1; i < meshless_dataset->number_of_groups; i++)
-	{
-		if     (vis_config->block_length == 512) fourier_transform_level_1 <512, false> (meshless_dataset->groups+i, vis_config);
-		else if(vis_config->block_length == 256) fourier_transform_level_1 <256, false> (meshless_dataset->groups+i, vis_config);
-		else if(vis_config->block_length == 128) fourier_transform_level_1 <128, false> (meshless_dataset->groups+i, vis_config);
-		else if(vis_config->block_length ==  64) fourier_transform_level_1 < 64, false> (meshless_dataset->groups+i, vis_config);
-		else if(vis_config->block_length ==  32) fourier_transform_level_1 < 32, false> (meshless_dataset->groups+i, vis_config);
-	}	
-}
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "fourier_transform_cpu.h"
+#include "fourier_transform_simd_cpu.h"
+#include "fourier_transform_rings_cpu.h"
+#include "fourier_transform_nufft_cpu.h"
+#include "fourier_transform_spectrum_cpu.h"
+#include "fourier_transform_tree_cpu.h"
+#include "fourier_transform_tables_cpu.h"
+#include "work_stealing_cpu.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#ifndef PI_F
+#define PI_F  3.141592653589793238462643383279f
+#endif
+
+#ifndef _2PI_F
+#define _2PI_F 6.283185307179586476925286766559f
+#endif
+
+inline void complex_assign(fftwf_complex& l, const float real, const float imag) { l[0] = real, l[1] = imag; }
+inline void complex_accumulate(fftwf_complex& l, const float real, const float imag) { l[0] += real, l[1] += imag; }
+
+inline float fourier_transform_sph(float r)
+{
+	if(r >= 0.06f) 
+	{
+		float m = PI_F*r;
+		float _2_m = 2.0f*m;
+		float cos_2_m = std::cos(_2_m), sin_2_m = std::sin(_2_m);
+		return ((2.3561944901923448f)/(m*m*m*m*m*m))*(cos_2_m-1.0f)*(cos_2_m+m*sin_2_m-1.0f);		// computing m**6 this way is much faster than pow(m,6)
+	}
+	return (PI_F + r*(-0.007968913156311f + r*(-18.293608272337678f)));		// a quadratic interpolant, note that PI_F is the value at zero
+}
+
+inline float fourier_transform_gaussian(float r)
+{
+	return std::exp(PI_F*r*r);
+}
+
+inline float fourier_transform_wendland_d3_c2(float r)
+{
+	if(r >= 0.24f) 
+	{
+		float m = PI_F*r;
+		float _2_m = 2.0f*m;
+		float cos_2_m = std::cos(_2_m), sin_2_m = std::sin(_2_m);
+		float m_2 = m*m;
+		float m_4 = m_2*m_2;
+		return ((PI_F*7.5f)/(m_4*m_4))*(4.0f*m_2 - 6.0f + (6.0f-m_2)*cos_2_m+4.5f*m*sin_2_m);
+	}
+	return 0.299199300341890f + r*(-0.002379178586124f + r*(-0.370530218163545f));
+}
+
+template <BasisFunctionId basis_function_id>
+inline float fourier_transform_basis_function(float r)
+{
+	if     (basis_function_id == SPH)            return fourier_transform_sph(r);
+	else if(basis_function_id == GAUSSIAN)       return fourier_transform_gaussian(r);
+	else                                         return fourier_transform_wendland_d3_c2(r);
+}
+
+template <BasisFunctionId basis_function_id>
+inline float basis_function_value(const VisConfig& vis_config, float r)
+{
+	const BasisFunctionTable* table = vis_config._basis_function_tables[basis_function_id];
+	return table ? basis_function_table_lookup(table, r) : fourier_transform_basis_function<basis_function_id>(r);
+}
+
+// The transforms in double precision and rearranged (or summed as a series) to avoid the cancellation that costs the float forms
+// above up to 5e-4 of their value at zero just past the thresholds.  The tables are built from these.
+double exact_fourier_transform(BasisFunctionId basis_function_id, double r)
+{
+	const double pi = 3.141592653589793238462643383279;
+	double m = pi*r;
+	if(basis_function_id == GAUSSIAN) return std::exp(pi*r*r);
+
+	if(basis_function_id == SPH)
+	{
+		// (3 pi/4)(cos 2m - 1)(cos 2m + m sin 2m - 1)/m^6 = 3 pi (sin m/m)^3 (sin m - m cos m)/m^3
+		double sinc = m > 0.0 ? std::sin(m)/m : 1.0, difference = 0.0;
+		if(m < 0.5)
+		{
+			// (sin m - m cos m)/m^3 = sum_{k>0} (-1)^(k+1) 2k m^(2k-2)/(2k+1)!
+			double power = 1.0, factorial = 1.0;
+			for(int k = 1; k < 12; k++)
+			{
+				factorial *= (2*k)*(2*k+1);
+				difference += (k % 2 ? 2.0 : -2.0)*k*power/factorial;
+				power *= m*m;
+			}
+		}
+		else difference = (std::sin(m) - m*std::cos(m))/(m*m*m);
+		return 3.0*pi*sinc*sinc*sinc*difference;
+	}
+
+	if(m < 2.0)
+	{
+		// (4m^2 - 6 + (6-m^2) cos 2m + 4.5 m sin 2m)/m^8, the terms below m^8 cancel exactly
+		double sum = 0.0, power = 1.0, cos_coefficient = 1.0, sin_coefficient = 2.0;	// (-1)^j 2^(2j)/(2j)! and (-1)^j 2^(2j+1)/(2j+1)!
+		for(int j = 1; j < 30; j++)
+		{
+			double previous_cos_coefficient = cos_coefficient;
+			cos_coefficient *= -4.0/((2*j-1)*(2*j));
+			double coefficient = 6.0*cos_coefficient - previous_cos_coefficient + 4.5*sin_coefficient;
+			sin_coefficient *= -4.0/((2*j)*(2*j+1));
+			if(j > 4) power *= m*m;
+			if(j >= 4) sum += coefficient*power;
+		}
+		return 7.5*pi*sum;
+	}
+	double m_4 = m*m*m*m;
+	return 7.5*pi*(4.0*m*m - 6.0 + (6.0-m*m)*std::cos(2.0*m) + 4.5*m*std::sin(2.0*m))/(m_4*m_4);
+}
+
+// Each interval's cubic interpolates the exact transform at t = 0, 1/3, 2/3 and 1, so neighbouring cubics meet, and the error is
+// measured at t = 1/6, 1/2 and 5/6.  The number of intervals is doubled until the error is within tolerance, or stops improving,
+// in which case the error it does achieve is reported.
+const int basis_function_table_intervals_per_unit = 16;
+const int basis_function_table_max_intervals = 1 << 18;
+const float gaussian_table_range = 5.2f;		// exp(pi r^2) overflows a float just past this, so the table stops there
+
+BasisFunctionTable* basis_function_table_create(BasisFunctionId basis_function_id, float range, float tolerance)
+{
+	if(basis_function_id == GAUSSIAN) range = std::min(range, gaussian_table_range);
+	double value_at_zero = std::fabs(exact_fourier_transform(basis_function_id, 0.0));
+
+	BasisFunctionTable* table = new BasisFunctionTable;
+	table->range = range;
+	table->tolerance = tolerance;
+	table->number_of_intervals = std::max(1, (int)std::ceil(range*basis_function_table_intervals_per_unit));
+	for(int i = 0; i < 4; i++) table->coefficients[i] = 0;
+
+	double previous_error = HUGE_VAL;
+	while(true)
+	{
+		int n = table->number_of_intervals;
+		double h = (double)range/n;
+		table->intervals_per_unit = (float)(n/(double)range);
+		for(int i = 0; i < 4; i++)
+		{
+			fftwf_free(table->coefficients[i]);
+			table->coefficients[i] = (float*)fftwf_malloc(sizeof(float)*n);
+		}
+
+		std::vector<double> interval_error(n, 0.0);
+		#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+		for(int i = 0; i < n; i++)
+		{
+			double f[4];
+			for(int j = 0; j < 4; j++) f[j] = exact_fourier_transform(basis_function_id, (i + j/3.0)*h);
+			table->coefficients[0][i] = (float)f[0];
+			table->coefficients[1][i] = (float)((-11.0*f[0] + 18.0*f[1] - 9.0*f[2] + 2.0*f[3])/2.0);
+			table->coefficients[2][i] = (float)(9.0*(2.0*f[0] - 5.0*f[1] + 4.0*f[2] - f[3])/2.0);
+			table->coefficients[3][i] = (float)(9.0*(-f[0] + 3.0*f[1] - 3.0*f[2] + f[3])/2.0);
+
+			for(int j = 1; j < 6; j += 2)
+			{
+				float r = (float)((i + j/6.0)*h);
+				double exact = exact_fourier_transform(basis_function_id, r);
+				interval_error[i] = std::max(interval_error[i], std::fabs(basis_function_table_lookup(table, r) - exact)/std::max(std::fabs(exact), value_at_zero));
+			}
+		}
+		double error = *std::max_element(interval_error.begin(), interval_error.end());
+		table->error = (float)error;
+
+		// halving the intervals should divide the error by 16, when it doesn't the rounding of the arguments to float has taken over
+		if(error <= tolerance || error > 0.5*previous_error || 2*n > basis_function_table_max_intervals) return table;
+		table->number_of_intervals = 2*n;
+		previous_error = error;
+	}
+}
+
+void basis_function_table_destroy(BasisFunctionTable* table)
+{
+	if(table == 0) return;
+	for(int i = 0; i < 4; i++) fftwf_free(table->coefficients[i]);
+	delete table;
+}
+
+// the farthest argument any kernel passes to the transform of basis_function_id: the farthest sample times the largest radius
+float reachable_basis_function_argument(VisConfig* vis_config, MeshlessDataset* meshless_dataset, BasisFunctionId basis_function_id)
+{
+	float fu = vis_config->step_size.x*vis_config->_cutoff_frequency.x, fv = vis_config->step_size.y*(vis_config->_cutoff_frequency.y-1);
+	float farthest_sample = sqrtf(fu*fu + fv*fv);
+	if(meshless_dataset == 0) return farthest_sample;
+
+	float largest_radius = 0.0f;
+	for(int j = 0; j < meshless_dataset->number_of_groups; j++)
+	{
+		Group* group = meshless_dataset->groups+j;
+		if(group->basis_function_id != basis_function_id) continue;
+		// registered terms are sorted by increasing radius
+		if(group->d_radii == 0) largest_radius = std::max(largest_radius, 1.0f);
+		else if(group->number_of_terms > 0) largest_radius = std::max(largest_radius, group->d_radii[group->number_of_terms-1]);
+	}
+	return farthest_sample*largest_radius;
+}
+
+void update_basis_function_tables(VisConfig* vis_config, MeshlessDataset* meshless_dataset)
+{
+	const BasisFunctionId basis_function_ids[3] = {SPH, GAUSSIAN, WENDLAND_D3_C2};
+	vis_config->_basis_function_table_error = 0.0f;
+
+	for(int i = 0; i < 3; i++)
+	{
+		BasisFunctionTable*& table = vis_config->_basis_function_tables[basis_function_ids[i]];
+		if(vis_config->basis_function_tolerance <= 0.0f)
+		{
+			basis_function_table_destroy(table);
+			table = 0;
+			continue;
+		}
+
+		// the tables are only ever grown, with some room to spare so zooming out a little doesn't rebuild them every frame
+		float range = reachable_basis_function_argument(vis_config, meshless_dataset, basis_function_ids[i]);
+		bool out_of_range = table && table->range < range && !(basis_function_ids[i] == GAUSSIAN && table->range >= gaussian_table_range);
+		if(table == 0 || out_of_range || table->tolerance != vis_config->basis_function_tolerance)
+		{
+			range = std::max(1.25f*range, table && table->tolerance == vis_config->basis_function_tolerance ? table->range : 0.0f);
+			basis_function_table_destroy(table);
+			table = basis_function_table_create(basis_function_ids[i], range > 0.0f ? range : 1.0f, vis_config->basis_function_tolerance);
+		}
+		vis_config->_basis_function_table_error = std::max(vis_config->_basis_function_table_error, table->error);
+	}
+}
+
+void destroy_basis_function_tables(VisConfig* vis_config)
+{
+	for(int i = 0; i < 3; i++)
+	{
+		basis_function_table_destroy(vis_config->_basis_function_tables[i]);
+		vis_config->_basis_function_tables[i] = 0;
+	}
+}
+
+// The argument past which the transform stays below epsilon times its value at zero, found by scanning down from where a bound on
+// its magnitude guarantees it.  The gaussian's transform never decays, so 0 is returned for it, which disables skipping terms.
+float negligible_basis_function_argument(BasisFunctionId basis_function_id, float epsilon)
+{
+	if(epsilon <= 0.0f || basis_function_id == GAUSSIAN) return 0.0f;
+
+	const double pi = 3.141592653589793238462643383279;
+	double threshold = epsilon*std::fabs(exact_fourier_transform(basis_function_id, 0.0));
+	double r = 1.0;
+	while(true)
+	{
+		double m = pi*r;
+		double bound = basis_function_id == SPH ? 3.0*pi*(1.0+m)/std::pow(m, 6.0) : 7.5*pi*(5.0*m*m + 4.5*m + 12.0)/std::pow(m, 8.0);
+		if(bound < threshold) break;
+		r *= 2.0;
+	}
+
+	const double step = 1.0/256.0;
+	while(r > 0.0 && std::fabs(exact_fourier_transform(basis_function_id, r)) < threshold) r -= step;
+	return (float)(r + step);
+}
+
+void update_negligible_arguments(VisConfig* vis_config)
+{
+	const BasisFunctionId basis_function_ids[3] = {SPH, GAUSSIAN, WENDLAND_D3_C2};
+	for(int i = 0; i < 3; i++) vis_config->_negligible_argument[basis_function_ids[i]] = negligible_basis_function_argument(basis_function_ids[i], vis_config->basis_function_epsilon);
+}
+
+// the coordinates of the sample stored at index of _d_freq_image
+inline void sample_coordinates(int index, const VisConfig& vis_config, int& x, int& y)
+{
+	x = index % (2*vis_config._cutoff_frequency.x);
+	if(x > vis_config._cutoff_frequency.x) x = x-(2*vis_config._cutoff_frequency.x);
+	y = index / (2*vis_config._cutoff_frequency.x);
+}
+
+void build_sample_rings(VisConfig* vis_config, std::vector<int>& begin, std::vector<int>& samples, std::vector<int>& destinations, std::vector<float>& radius, std::vector<int>& tile_begin, SampleRings& rings)
+{
+	int image_size = 2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y;
+	bool isotropic = vis_config->step_size.x == vis_config->step_size.y;
+
+	std::vector<std::pair<long, int> > keys;
+	keys.reserve(image_size);
+	for(int index = 0; index < image_size; index++)
+	{
+		int x, y;
+		sample_coordinates(index, *vis_config, x, y);
+		if(sample_destination(*vis_config, x, y) == 0) continue;
+		keys.push_back(std::make_pair(isotropic ? (long)x*x + (long)y*y : (long)std::abs(x)*vis_config->_cutoff_frequency.y + y, index));
+	}
+	std::sort(keys.begin(), keys.end());
+
+	int number_of_samples = (int)keys.size();
+	rings.image = vis_config->_arrange_samples_in_kernels ? vis_config->_d_freq_image_arranged : vis_config->_d_freq_image;
+	begin.clear(), samples.resize(number_of_samples), destinations.resize(number_of_samples), radius.clear();
+	for(int i = 0; i < number_of_samples; i++)
+	{
+		int x, y;
+		samples[i] = keys[i].second;
+		sample_coordinates(samples[i], *vis_config, x, y);
+		destinations[i] = (int)(sample_destination(*vis_config, x, y) - rings.image);
+		if(i == 0 || keys[i].first != keys[i-1].first)
+		{
+			begin.push_back(i);
+			float fu = vis_config->step_size.x*x, fv = vis_config->step_size.y*y;
+			radius.push_back(sqrtf(fu*fu + fv*fv));
+		}
+	}
+	begin.push_back(number_of_samples);
+	rings.number_of_rings = (int)radius.size();
+
+	tile_begin.clear();
+	rings.largest_tile = rings.most_rings_per_tile = 0;
+	for(int ring = 0; ring < rings.number_of_rings; )
+	{
+		int first = ring;
+		do ring++; while(ring < rings.number_of_rings && begin[ring] - begin[first] < vis_config->tile_samples);
+		tile_begin.push_back(first);
+		rings.largest_tile = std::max(rings.largest_tile, begin[ring] - begin[first]);
+		rings.most_rings_per_tile = std::max(rings.most_rings_per_tile, ring - first);
+	}
+	tile_begin.push_back(rings.number_of_rings);
+	rings.number_of_tiles = (int)tile_begin.size() - 1;
+
+	rings.begin = &begin[0], rings.samples = samples.empty() ? 0 : &samples[0], rings.radius = radius.empty() ? 0 : &radius[0];
+	rings.destinations = destinations.empty() ? 0 : &destinations[0];
+	rings.tile_begin = &tile_begin[0];
+}
+
+// scales the sums of a tile's samples and writes them out, without radii the basis function is applied here
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii>
+void write_tile(const VisConfig& vis_config, const SampleRings& rings, int tile, const float2* sum)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	const int* destinations = rings.destinations + rings.begin[first_ring];
+	for(int ring = first_ring; ring < last_ring; ring++)
+	{
+		float scale = vis_config._scale;
+		if(!has_radii) scale *= basis_function_value<basis_function_id>(vis_config, rings.radius[ring]);
+
+		for(int i = rings.begin[ring] - rings.begin[first_ring]; i < rings.begin[ring+1] - rings.begin[first_ring]; i++)
+		{
+			if(is_first_group) complex_assign(rings.image[destinations[i]], sum[i].x*scale, -sum[i].y*scale);
+			else           complex_accumulate(rings.image[destinations[i]], sum[i].x*scale, -sum[i].y*scale);
+		}
+	}
+}
+
+// Adds up the partial sums, partial_sums[partition*number_of_ring_samples + i] for the i-th sample of the rings, and writes them out.
+// They're added in the same order whichever threads computed them, so the image doesn't depend on the scheduling.  Called by every
+// thread of the kernel's parallel region, sum is the thread's scratch for a tile.
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii>
+void reduce_partial_sums(const VisConfig& vis_config, const SampleRings& rings, const float2* partial_sums, int number_of_partitions, float2* sum)
+{
+	int number_of_ring_samples = rings.begin[rings.number_of_rings];
+
+	#pragma omp barrier
+	#pragma omp for schedule(dynamic,1) nowait
+	for(int tile = 0; tile < rings.number_of_tiles; tile++)
+	{
+		int begin = rings.begin[rings.tile_begin[tile]], end = rings.begin[rings.tile_begin[tile+1]];
+		for(int i = begin; i < end; i++)
+		{
+			float2 total = partial_sums[i];
+			for(int partition = 1; partition < number_of_partitions; partition++)
+			{
+				total.x += partial_sums[partition*number_of_ring_samples + i].x, total.y += partial_sums[partition*number_of_ring_samples + i].y;
+			}
+			sum[i-begin] = total;
+		}
+		write_tile<is_first_group, basis_function_id, has_radii>(vis_config, rings, tile, sum);
+	}
+}
+
+// maps a tile's samples from image space into frequency space
+void tile_coordinates(const VisConfig& vis_config, const SampleRings& rings, int tile, float3* f_coord)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	const int* samples = rings.samples + rings.begin[first_ring];
+	int number_of_samples = rings.begin[last_ring] - rings.begin[first_ring];
+	for(int i = 0; i < number_of_samples; i++)
+	{
+		int x, y;
+		sample_coordinates(samples[i], vis_config, x, y);
+
+		// compute the image space coordinates
+		float fu = vis_config.step_size.x*x, fv = vis_config.step_size.y*y;
+
+		// map from image space into frequency space
+		f_coord[i] = make_float3(fu*vis_config.u_axis.x + fv*vis_config.v_axis.x, fu*vis_config.u_axis.y + fv*vis_config.v_axis.y, fu*vis_config.u_axis.z + fv*vis_config.v_axis.z);
+	}
+}
+
+// ring_basis[(ring-first_ring)*number_of_distinct_radii + d] for the group's tabulated radii
+template <BasisFunctionId basis_function_id>
+void tabulate_ring_basis(const Group& group, const VisConfig& vis_config, const SampleRings& rings, int tile, float* ring_basis)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	for(int ring = first_ring; ring < last_ring; ring++)
+	{
+		float* basis = ring_basis + (ring-first_ring)*group.number_of_distinct_radii;
+		for(int d = 0; d < group.number_of_distinct_radii; d++) basis[d] = basis_function_value<basis_function_id>(vis_config, rings.radius[ring]*group.d_distinct_radii[d]);
+	}
+}
+
+// adds terms first_term ... end_term-1 of the group to the sums of the tile's samples, chunk_length terms at a time
+template <BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void sum_tile(const Group& group, const VisConfig& vis_config, const SampleRings& rings, int tile, int first_term, int end_term, int chunk_length, const float3* f_coord, const float* ring_basis, float2* sum)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	for(int chunk = first_term; chunk < end_term; chunk += chunk_length)
+	{
+		int chunk_end = std::min(chunk + chunk_length, end_term);
+		for(int ring = first_ring; ring < last_ring; ring++)
+		{
+			float r = rings.radius[ring];
+			int first = rings.begin[ring] - rings.begin[first_ring], last = rings.begin[ring+1] - rings.begin[first_ring];
+			const float* basis = tabulated_radii ? ring_basis + (ring-first_ring)*group.number_of_distinct_radii : 0;
+			int last_term = std::min(chunk_end, number_of_contributing_terms(group, vis_config._negligible_argument[basis_function_id], r));
+
+			for(int k = chunk; k < last_term; k++) 
+			{
+				// without radii the basis function is the same for every term, so it's applied when the sums are written out
+				float term = group.d_weights[k];
+				if     (tabulated_radii) term *= basis[group.d_radius_indices[k]];
+				else if(has_radii)       term *= basis_function_value<basis_function_id>(vis_config, r*group.d_radii[k]);
+
+				for(int i = first; i < last; i++)
+				{
+					float v = _2PI_F*(f_coord[i].x*group.d_x[k] + f_coord[i].y*group.d_y[k] + f_coord[i].z*group.d_z[k]);
+					sum[i].x += term*std::cos(v);
+					sum[i].y += term*std::sin(v);
+				}
+			}
+		}
+	}
+}
+
+// the range of chunks a partition of number_of_chunks chunks covers
+inline void partition_chunks(int partition, int number_of_partitions, int number_of_chunks, int& first_chunk, int& end_chunk)
+{
+	first_chunk = (int)((long long)number_of_chunks*partition/number_of_partitions);
+	end_chunk = (int)((long long)number_of_chunks*(partition+1)/number_of_partitions);
+}
+
+// Every task sums one tile of samples over one partition of the terms (see number_of_term_partitions in work_stealing_cpu.h), the
+// tasks of a tile are numbered consecutively so a thread working through its share keeps the tile's coordinates and basis functions.
+// With tabulated_radii the group's radii are looked up in d_distinct_radii, see tabulate_distinct_radii in meshless_vis_cpu.cpp
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void sample_fourier_transform_over_grid(Group group, VisConfig vis_config, SampleRings rings)
+{
+	int chunk_length = std::max(1, vis_config.tile_terms);
+	int number_of_chunks = (group.d_number_of_terms + chunk_length - 1)/chunk_length;
+	int number_of_partitions = number_of_term_partitions(vis_config, rings.number_of_tiles, number_of_chunks);
+
+	int number_of_ring_samples = rings.begin[rings.number_of_rings];
+	std::vector<float2> partial_sums(number_of_partitions > 1 ? number_of_partitions*number_of_ring_samples : 0);
+	WorkStealingTasks tasks(rings.number_of_tiles*number_of_partitions, vis_get_number_of_threads());
+
+	// each thread reads the copy of the terms on its own NUMA node, if the group has been replicated (see memory_cpu.h)
+	const Group& shared_group = group;
+	#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+	{
+		const Group& group = node_local_group(shared_group);
+		std::vector<float3> f_coord(rings.largest_tile);
+		std::vector<float2> sum(rings.largest_tile);
+		std::vector<float> ring_basis(tabulated_radii ? group.number_of_distinct_radii*rings.most_rings_per_tile : 0);
+
+		int task, current_tile = -1;
+		while(tasks.next(task))
+		{
+			int tile = task/number_of_partitions, partition = task%number_of_partitions;
+			int number_of_samples = rings.begin[rings.tile_begin[tile+1]] - rings.begin[rings.tile_begin[tile]];
+			if(tile != current_tile)
+			{
+				tile_coordinates(vis_config, rings, tile, &f_coord[0]);
+				if(tabulated_radii) tabulate_ring_basis<basis_function_id>(group, vis_config, rings, tile, &ring_basis[0]);
+				current_tile = tile;
+			}
+			for(int i = 0; i < number_of_samples; i++) sum[i] = make_float2(0.0f, 0.0f);
+
+			int first_chunk, end_chunk;
+			partition_chunks(partition, number_of_partitions, number_of_chunks, first_chunk, end_chunk);
+			sum_tile<basis_function_id, has_radii, tabulated_radii>(group, vis_config, rings, tile, first_chunk*chunk_length, std::min(group.d_number_of_terms, end_chunk*chunk_length), chunk_length, &f_coord[0], tabulated_radii ? &ring_basis[0] : 0, &sum[0]);
+
+			if(number_of_partitions == 1) write_tile<is_first_group, basis_function_id, has_radii>(vis_config, rings, tile, &sum[0]);
+			else std::copy(sum.begin(), sum.begin() + number_of_samples, partial_sums.begin() + partition*number_of_ring_samples + rings.begin[rings.tile_begin[tile]]);
+		}
+
+		if(number_of_partitions > 1) reduce_partial_sums<is_first_group, basis_function_id, has_radii>(vis_config, rings, &partial_sums[0], number_of_partitions, &sum[0]);
+	}
+}
+
+template <bool is_first_group, BasisFunctionId basis_function_id>
+void fourier_transform_level_2(Group* group, VisConfig* vis_config, const SampleRings* rings)
+{
+	if     (group->d_radii && group->number_of_distinct_radii > 0) sample_fourier_transform_over_grid <is_first_group, basis_function_id, true, true>   (*group, *vis_config, *rings);
+	else if(group->d_radii)                                         sample_fourier_transform_over_grid <is_first_group, basis_function_id, true, false>  (*group, *vis_config, *rings);
+	else                                                            sample_fourier_transform_over_grid <is_first_group, basis_function_id, false, false> (*group, *vis_config, *rings);
+}
+
+template <bool is_first_group>
+void fourier_transform_level_1(Group* group, VisConfig* vis_config, const SampleRings* rings)
+{
+	if     (group->basis_function_id == SPH)            fourier_transform_level_2 <is_first_group, SPH>            (group, vis_config, rings);
+	else if(group->basis_function_id == GAUSSIAN)       fourier_transform_level_2 <is_first_group, GAUSSIAN>       (group, vis_config, rings);
+	else if(group->basis_function_id == WENDLAND_D3_C2) fourier_transform_level_2 <is_first_group, WENDLAND_D3_C2> (group, vis_config, rings);
+}
+
+// Adds one group's terms to the sums of a tile's samples for sample_fourier_transform_over_grid_fused.  Groups with radii add
+// straight into sum, the others into group_sum first, to apply their basis function ring by ring.
+typedef void (*GroupTileSum)(const Group& group, const VisConfig& vis_config, const SampleRings& rings, int tile, int first_term, int end_term,
+	const float3* f_coord, float* ring_basis, float2* group_sum, float2* sum);
+
+template <BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void add_group_tile_sum(const Group& group, const VisConfig& vis_config, const SampleRings& rings, int tile, int first_term, int end_term,
+	const float3* f_coord, float* ring_basis, float2* group_sum, float2* sum)
+{
+	int chunk_length = std::max(1, vis_config.tile_terms);
+	if(tabulated_radii) tabulate_ring_basis<basis_function_id>(group, vis_config, rings, tile, ring_basis);
+	if(has_radii)
+	{
+		sum_tile<basis_function_id, has_radii, tabulated_radii>(group, vis_config, rings, tile, first_term, end_term, chunk_length, f_coord, ring_basis, sum);
+		return;
+	}
+
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	for(int i = 0; i < rings.begin[last_ring] - rings.begin[first_ring]; i++) group_sum[i] = make_float2(0.0f, 0.0f);
+	sum_tile<basis_function_id, has_radii, tabulated_radii>(group, vis_config, rings, tile, first_term, end_term, chunk_length, f_coord, ring_basis, group_sum);
+	for(int ring = first_ring; ring < last_ring; ring++)
+	{
+		float basis = basis_function_value<basis_function_id>(vis_config, rings.radius[ring]);
+		for(int i = rings.begin[ring] - rings.begin[first_ring]; i < rings.begin[ring+1] - rings.begin[first_ring]; i++)
+		{
+			sum[i].x += basis*group_sum[i].x, sum[i].y += basis*group_sum[i].y;
+		}
+	}
+}
+
+template <BasisFunctionId basis_function_id>
+GroupTileSum group_tile_sum_level_2(const Group& group)
+{
+	if     (group.d_radii && group.number_of_distinct_radii > 0) return add_group_tile_sum <basis_function_id, true, true>;
+	else if(group.d_radii)                                        return add_group_tile_sum <basis_function_id, true, false>;
+	else                                                          return add_group_tile_sum <basis_function_id, false, false>;
+}
+
+GroupTileSum group_tile_sum_level_1(const Group& group)
+{
+	if     (group.basis_function_id == GAUSSIAN)       return group_tile_sum_level_2 <GAUSSIAN>       (group);
+	else if(group.basis_function_id == WENDLAND_D3_C2) return group_tile_sum_level_2 <WENDLAND_D3_C2> (group);
+	else                                               return group_tile_sum_level_2 <SPH>            (group);
+}
+
+// Direct summation over all the groups of the dataset in one pass: every sample is visited once and written once, instead of once
+// per group, and the groups' terms are partitioned together so small groups don't each pay for a pass over the image.  The chunks
+// of the groups are numbered one after the other and the partitions cover ranges of them, see sample_fourier_transform_over_grid.
+void sample_fourier_transform_over_grid_fused(const MeshlessDataset& meshless_dataset, const VisConfig& vis_config, const SampleRings& rings)
+{
+	int number_of_groups = meshless_dataset.number_of_groups;
+	int chunk_length = std::max(1, vis_config.tile_terms);
+
+	// group g's chunks are chunks chunk_begin[g] ... chunk_begin[g+1]-1 of the dataset
+	std::vector<GroupTileSum> group_tile_sums(number_of_groups);
+	std::vector<int> chunk_begin(number_of_groups+1, 0);
+	int most_distinct_radii = 0;
+	for(int g = 0; g < number_of_groups; g++)
+	{
+		const Group& group = meshless_dataset.groups[g];
+		group_tile_sums[g] = group_tile_sum_level_1(group);
+		chunk_begin[g+1] = chunk_begin[g] + (group.d_number_of_terms + chunk_length - 1)/chunk_length;
+		most_distinct_radii = std::max(most_distinct_radii, group.number_of_distinct_radii);
+	}
+	int number_of_chunks = chunk_begin[number_of_groups];
+	int number_of_partitions = number_of_term_partitions(vis_config, rings.number_of_tiles, number_of_chunks);
+
+	int number_of_ring_samples = rings.begin[rings.number_of_rings];
+	std::vector<float2> partial_sums(number_of_partitions > 1 ? number_of_partitions*number_of_ring_samples : 0);
+	WorkStealingTasks tasks(rings.number_of_tiles*number_of_partitions, vis_get_number_of_threads());
+
+	#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+	{
+		std::vector<float3> f_coord(rings.largest_tile);
+		std::vector<float2> sum(rings.largest_tile), group_sum(rings.largest_tile);
+		std::vector<float> ring_basis(most_distinct_radii*rings.most_rings_per_tile + 1);
+
+		int task, current_tile = -1;
+		while(tasks.next(task))
+		{
+			int tile = task/number_of_partitions, partition = task%number_of_partitions;
+			int number_of_samples = rings.begin[rings.tile_begin[tile+1]] - rings.begin[rings.tile_begin[tile]];
+			if(tile != current_tile)
+			{
+				tile_coordinates(vis_config, rings, tile, &f_coord[0]);
+				current_tile = tile;
+			}
+			for(int i = 0; i < number_of_samples; i++) sum[i] = make_float2(0.0f, 0.0f);
+
+			int first_chunk, end_chunk;
+			partition_chunks(partition, number_of_partitions, number_of_chunks, first_chunk, end_chunk);
+			for(int g = 0; g < number_of_groups; g++)
+			{
+				int first = std::max(first_chunk, chunk_begin[g]) - chunk_begin[g], end = std::min(end_chunk, chunk_begin[g+1]) - chunk_begin[g];
+				if(first >= end) continue;
+				const Group& group = node_local_group(meshless_dataset.groups[g]);
+				group_tile_sums[g](group, vis_config, rings, tile, first*chunk_length, std::min(group.d_number_of_terms, end*chunk_length), &f_coord[0], &ring_basis[0], &group_sum[0], &sum[0]);
+			}
+
+			// the groups' basis functions have been applied, so writing out only scales, as for a single group with radii
+			if(number_of_partitions == 1) write_tile<true, SPH, true>(vis_config, rings, tile, &sum[0]);
+			else std::copy(sum.begin(), sum.begin() + number_of_samples, partial_sums.begin() + partition*number_of_ring_samples + rings.begin[rings.tile_begin[tile]]);
+		}
+
+		if(number_of_partitions > 1) reduce_partial_sums<true, SPH, true>(vis_config, rings, &partial_sums[0], number_of_partitions, &sum[0]);
+	}
+}
+
+// The phase recurrence walks each row of samples from left to right.  Since the samples are evenly spaced along u, moving one
+// sample to the right multiplies every term's phase factor exp(2 pi i f.p) by exp(2 pi i step_size.x u.p), so after projecting
+// the terms onto the image axes we only need sin and cos at the start of a run of samples.  recurrence_width neighbouring
+// samples are advanced together (each by recurrence_width steps) so the inner loop has independent iterations.  Every
+// recurrence_reseed_interval samples the phase is evaluated exactly again, which keeps the rounding error from growing.
+// The vectorized kernels in fourier_transform_simd_cpu.inl do the same with one register of samples in place of recurrence_width.
+const int recurrence_width = 8;
+const int recurrence_reseed_interval = 64;
+
+inline void phase_factor(double turns, float& real, float& imag)
+{
+	turns -= std::floor(turns);
+	real = (float)std::cos(6.283185307179586476925286766559*turns), imag = (float)std::sin(6.283185307179586476925286766559*turns);
+}
+
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void sample_fourier_transform_over_grid_by_recurrence(Group group, VisConfig vis_config)
+{
+	int cutoff_x = vis_config._cutoff_frequency.x;
+	int row_length = 2*cutoff_x;
+	int padded_row_length = recurrence_width*((row_length + recurrence_width - 1)/recurrence_width);
+
+	// project the terms onto the image axes, in turns per sample, and compute the rotation for one and for recurrence_width samples
+	std::vector<float> u_phase(group.d_number_of_terms), v_phase(group.d_number_of_terms);
+	std::vector<float> step_real(group.d_number_of_terms), step_imag(group.d_number_of_terms), width_step_real(group.d_number_of_terms), width_step_imag(group.d_number_of_terms);
+
+	#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+	for(int k = 0; k < group.d_number_of_terms; k++)
+	{
+		u_phase[k] = vis_config.step_size.x*(vis_config.u_axis.x*group.d_x[k] + vis_config.u_axis.y*group.d_y[k] + vis_config.u_axis.z*group.d_z[k]);
+		v_phase[k] = vis_config.step_size.y*(vis_config.v_axis.x*group.d_x[k] + vis_config.v_axis.y*group.d_y[k] + vis_config.v_axis.z*group.d_z[k]);
+		phase_factor(u_phase[k], step_real[k], step_imag[k]);
+		phase_factor(recurrence_width*(double)u_phase[k], width_step_real[k], width_step_imag[k]);
+	}
+
+	// each thread reads the copy of the terms on its own node, see sample_fourier_transform_over_grid
+	const Group& shared_group = group;
+	#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+	{
+		const Group& group = node_local_group(shared_group);
+		// the samples of a row are stored in order of increasing x, starting at 1-cutoff_x
+		std::vector<float> r(padded_row_length), sum_real(padded_row_length), sum_imag(padded_row_length);
+		std::vector<float> row_basis(tabulated_radii ? group.number_of_distinct_radii*padded_row_length : 0);	// row_basis[d*padded_row_length + i]
+		float real[recurrence_width], imag[recurrence_width], term[recurrence_width];
+
+		#pragma omp for schedule(dynamic,1) nowait
+		for(int y = 0; y < vis_config._cutoff_frequency.y; y++)
+		{
+			float fv = vis_config.step_size.y*y;
+			for(int i = 0; i < padded_row_length; i++)
+			{
+				float fu = vis_config.step_size.x*(i+1-cutoff_x);
+				r[i] = sqrtf(fu*fu + fv*fv);
+				sum_real[i] = sum_imag[i] = 0.0f;
+			}
+			if(tabulated_radii)
+			{
+				for(int d = 0; d < group.number_of_distinct_radii; d++)
+				{
+					for(int i = 0; i < padded_row_length; i++) row_basis[d*padded_row_length + i] = basis_function_value<basis_function_id>(vis_config, r[i]*group.d_distinct_radii[d]);
+				}
+			}
+
+			// the samples nearest the origin are at distance fv, the terms that are negligible there are negligible for the whole row
+			int number_of_terms = number_of_contributing_terms(group, vis_config._negligible_argument[basis_function_id], fv);
+			for(int k = 0; k < number_of_terms; k++)
+			{
+				float weight = group.d_weights[k];
+				if(weight == 0.0f) continue;	// padding
+
+				float rotation_real = width_step_real[k], rotation_imag = width_step_imag[k];
+
+				for(int first = 0; first < padded_row_length; first += recurrence_reseed_interval)
+				{
+					phase_factor((first+1-cutoff_x)*(double)u_phase[k] + y*(double)v_phase[k], real[0], imag[0]);
+					for(int j = 1; j < recurrence_width; j++)
+					{
+						real[j] = real[j-1]*step_real[k] - imag[j-1]*step_imag[k];
+						imag[j] = real[j-1]*step_imag[k] + imag[j-1]*step_real[k];
+					}
+
+					int last = std::min(first + recurrence_reseed_interval, padded_row_length);
+					for(int i = first; i < last; i += recurrence_width)
+					{
+						if     (tabulated_radii) for(int j = 0; j < recurrence_width; j++) term[j] = weight*row_basis[group.d_radius_indices[k]*padded_row_length + i+j];
+						else if(has_radii)       for(int j = 0; j < recurrence_width; j++) term[j] = weight*basis_function_value<basis_function_id>(vis_config, r[i+j]*group.d_radii[k]);
+						else                     for(int j = 0; j < recurrence_width; j++) term[j] = weight;
+
+						for(int j = 0; j < recurrence_width; j++)
+						{
+							sum_real[i+j] += term[j]*real[j];
+							sum_imag[i+j] += term[j]*imag[j];
+							float rotated_real = real[j]*rotation_real - imag[j]*rotation_imag;
+							imag[j] = real[j]*rotation_imag + imag[j]*rotation_real;
+							real[j] = rotated_real;
+						}
+					}
+				}
+			}
+
+			for(int i = 0; i < row_length; i++)
+			{
+				fftwf_complex* sample = sample_destination(vis_config, i+1-cutoff_x, y);
+				if(sample == 0) continue;
+				float scale = vis_config._scale;
+				if(!has_radii) scale *= basis_function_value<basis_function_id>(vis_config, r[i]);	// constant over the terms, so it was factored out
+
+				if(is_first_group) complex_assign(*sample, sum_real[i]*scale, -sum_imag[i]*scale);
+				else           complex_accumulate(*sample, sum_real[i]*scale, -sum_imag[i]*scale);
+			}
+		}
+	}
+}
+
+template <bool is_first_group, BasisFunctionId basis_function_id>
+void fourier_transform_by_recurrence_level_2(Group* group, VisConfig* vis_config)
+{
+	if     (group->d_radii && group->number_of_distinct_radii > 0) sample_fourier_transform_over_grid_by_recurrence <is_first_group, basis_function_id, true, true>   (*group, *vis_config);
+	else if(group->d_radii)                                         sample_fourier_transform_over_grid_by_recurrence <is_first_group, basis_function_id, true, false>  (*group, *vis_config);
+	else                                                            sample_fourier_transform_over_grid_by_recurrence <is_first_group, basis_function_id, false, false> (*group, *vis_config);
+}
+
+template <bool is_first_group>
+void fourier_transform_by_recurrence_level_1(Group* group, VisConfig* vis_config)
+{
+	if     (group->basis_function_id == SPH)            fourier_transform_by_recurrence_level_2 <is_first_group, SPH>            (group, vis_config);
+	else if(group->basis_function_id == GAUSSIAN)       fourier_transform_by_recurrence_level_2 <is_first_group, GAUSSIAN>       (group, vis_config);
+	else if(group->basis_function_id == WENDLAND_D3_C2) fourier_transform_by_recurrence_level_2 <is_first_group, WENDLAND_D3_C2> (group, vis_config);
+}
+
+// The non-uniform FFT and the spectrum slices compute sum_k weight_k exp(2 pi i f.p_k) over the whole grid at once, so the basis
+// function has to be applied afterwards, one sample at a time.  That is only possible when it is the same for every term, i.e.
+// when there are no radii or they are all equal.  Otherwise they return false and the group is summed directly.
+inline bool get_common_radius(Group* group, float& r0)
+{
+	r0 = 1.0f;
+	if(group->d_radii == 0) return true;
+
+	r0 = group->d_radii[0];
+	for(int k = 1; k < group->number_of_terms; k++) if(group->d_radii[k] != r0) return false;
+	return true;
+}
+
+// sums is stored in rows of increasing x, starting at 1-cutoff_x
+template <bool is_first_group, BasisFunctionId basis_function_id>
+void apply_basis_function(VisConfig* vis_config, const fftwf_complex* sums, float r0)
+{
+	int cutoff_x = vis_config->_cutoff_frequency.x;
+	int row_length = 2*cutoff_x;
+
+	#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+	for(int y = 0; y < vis_config->_cutoff_frequency.y; y++)
+	{
+		float fv = vis_config->step_size.y*y;
+		for(int i = 0; i < row_length; i++)
+		{
+			int x = i+1-cutoff_x;
+			fftwf_complex* sample = sample_destination(*vis_config, x, y);
+			if(sample == 0) continue;
+			float fu = vis_config->step_size.x*x;
+			float scale = vis_config->_scale*basis_function_value<basis_function_id>(*vis_config, sqrtf(fu*fu + fv*fv)*r0);
+
+			if(is_first_group) complex_assign(*sample, sums[y*row_length+i][0]*scale, -sums[y*row_length+i][1]*scale);
+			else           complex_accumulate(*sample, sums[y*row_length+i][0]*scale, -sums[y*row_length+i][1]*scale);
+		}
+	}
+}
+
+template <bool is_first_group, BasisFunctionId basis_function_id>
+bool fourier_transform_by_nufft(Group* group, VisConfig* vis_config)
+{
+	float r0;
+	if(!get_common_radius(group, r0)) return false;
+
+	int cutoff_x = vis_config->_cutoff_frequency.x;
+	int row_length = 2*cutoff_x;
+
+	// project the terms onto the image axes, in turns per sample
+	std::vector<float> u_phase(group->number_of_terms), v_phase(group->number_of_terms);
+
+	#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+	for(int k = 0; k < group->number_of_terms; k++)
+	{
+		u_phase[k] = vis_config->step_size.x*(vis_config->u_axis.x*group->d_x[k] + vis_config->u_axis.y*group->d_y[k] + vis_config->u_axis.z*group->d_z[k]);
+		v_phase[k] = vis_config->step_size.y*(vis_config->v_axis.x*group->d_x[k] + vis_config->v_axis.y*group->d_y[k] + vis_config->v_axis.z*group->d_z[k]);
+	}
+
+	fftwf_complex* sums = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*row_length*vis_config->_cutoff_frequency.y);
+	nufft_type_1(group->number_of_terms, &u_phase[0], &v_phase[0], group->d_weights, 1-cutoff_x, row_length, vis_config->_cutoff_frequency.y, vis_config->nufft_tolerance, sums);
+	apply_basis_function <is_first_group, basis_function_id> (vis_config, sums, r0);
+	fftwf_free(sums);
+	return true;
+}
+
+inline bool spectrum_covers(const GroupSpectrum* spectrum, float radius, float tolerance)
+{
+	return spectrum != 0 && spectrum->radius >= radius && spectrum->tolerance <= tolerance;
+}
+
+// Returns the group's spectrum with a reference for the caller, after replacing it if it doesn't reach radius or isn't accurate to
+// tolerance.  The replacement reaches as far and is as accurate as the old one too, so that configs asking for different radii or
+// tolerances don't rebuild it back and forth.  It's built outside the lock, and the old one lives on until the renders slicing it
+// release it.
+GroupSpectrum* acquire_spectrum(Group* group, float radius, float tolerance)
+{
+	GroupSpectrum* spectrum = 0;
+	#pragma omp critical(group_spectrum)
+	{
+		if(spectrum_covers(group->d_spectrum, radius, tolerance)) spectrum = group->d_spectrum, spectrum->references++;
+		else if(group->d_spectrum) radius = std::max(radius, group->d_spectrum->radius), tolerance = std::min(tolerance, group->d_spectrum->tolerance);
+	}
+	if(spectrum) return spectrum;
+
+	GroupSpectrum* built = spectrum_create(group, radius, tolerance);
+	GroupSpectrum* released = 0;
+	#pragma omp critical(group_spectrum)
+	{
+		// another render may have replaced the spectrum meanwhile
+		if(spectrum_covers(group->d_spectrum, radius, tolerance))
+		{
+			spectrum = group->d_spectrum, spectrum->references++;
+			released = built;
+		}
+		else
+		{
+			if(group->d_spectrum && --group->d_spectrum->references == 0) released = group->d_spectrum;
+			group->d_spectrum = spectrum = built;
+			spectrum->references++;
+		}
+	}
+	spectrum_destroy(released);
+	return spectrum;
+}
+
+// the spectrum is built the first time it is needed and kept until the dataset is unregistered, it is only rebuilt if the samples
+// reach further out than it does or a tighter tolerance is asked for, rotating, zooming in and changing the number of samples reuse it
+template <bool is_first_group, BasisFunctionId basis_function_id>
+bool fourier_transform_by_spectrum_slice(Group* group, VisConfig* vis_config)
+{
+	float r0;
+	if(!get_common_radius(group, r0)) return false;
+
+	float fu = vis_config->step_size.x*vis_config->_cutoff_frequency.x, fv = vis_config->step_size.y*(vis_config->_cutoff_frequency.y-1);
+	float radius = sqrtf(fu*fu + fv*fv);
+	fftwf_complex* sums = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y);
+
+	GroupSpectrum* spectrum = acquire_spectrum(group, radius, vis_config->nufft_tolerance);
+	spectrum_slice(spectrum, vis_config, sums);
+	spectrum_release(spectrum);
+	apply_basis_function <is_first_group, basis_function_id> (vis_config, sums, r0);
+	fftwf_free(sums);
+	return true;
+}
+
+template <bool is_first_group, BasisFunctionId basis_function_id>
+bool fourier_transform_by_tree(Group* group, VisConfig* vis_config, const SampleRings* rings)
+{
+	float r0;
+	if(!get_common_radius(group, r0)) return false;
+	#pragma omp critical(group_tree)
+	if(group->d_tree == 0) group->d_tree = tree_create(group);
+
+	fftwf_complex* sums = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y);
+	tree_sum(group->d_tree, vis_config, rings, vis_config->nufft_tolerance, sums);
+	apply_basis_function <is_first_group, basis_function_id> (vis_config, sums, r0);
+	fftwf_free(sums);
+	return true;
+}
+
+template <bool is_first_group>
+bool fourier_transform_by_nufft_level_1(Group* group, VisConfig* vis_config)
+{
+	if     (group->basis_function_id == SPH)            return fourier_transform_by_nufft <is_first_group, SPH>            (group, vis_config);
+	else if(group->basis_function_id == GAUSSIAN)       return fourier_transform_by_nufft <is_first_group, GAUSSIAN>       (group, vis_config);
+	else if(group->basis_function_id == WENDLAND_D3_C2) return fourier_transform_by_nufft <is_first_group, WENDLAND_D3_C2> (group, vis_config);
+	return false;
+}
+
+template <bool is_first_group>
+bool fourier_transform_by_spectrum_slice_level_1(Group* group, VisConfig* vis_config)
+{
+	if     (group->basis_function_id == SPH)            return fourier_transform_by_spectrum_slice <is_first_group, SPH>            (group, vis_config);
+	else if(group->basis_function_id == GAUSSIAN)       return fourier_transform_by_spectrum_slice <is_first_group, GAUSSIAN>       (group, vis_config);
+	else if(group->basis_function_id == WENDLAND_D3_C2) return fourier_transform_by_spectrum_slice <is_first_group, WENDLAND_D3_C2> (group, vis_config);
+	return false;
+}
+
+template <bool is_first_group>
+bool fourier_transform_by_tree_level_1(Group* group, VisConfig* vis_config, const SampleRings* rings)
+{
+	if     (group->basis_function_id == SPH)            return fourier_transform_by_tree <is_first_group, SPH>            (group, vis_config, rings);
+	else if(group->basis_function_id == GAUSSIAN)       return fourier_transform_by_tree <is_first_group, GAUSSIAN>       (group, vis_config, rings);
+	else if(group->basis_function_id == WENDLAND_D3_C2) return fourier_transform_by_tree <is_first_group, WENDLAND_D3_C2> (group, vis_config, rings);
+	return false;
+}
+
+// runs the widest vectorized kernel allowed by vis_config->instruction_set and supported by the processor, returns false if there is none
+// (the vectorized kernels handle VIS_PHASE_RECURRENCE, and direct summation for everything else)
+bool fourier_transform_simd(Group* group, VisConfig* vis_config, const SampleRings* rings, bool is_first_group)
+{
+#ifdef MESHLESS_VIS_HAVE_X86_SIMD
+	VisInstructionSet instruction_set = std::min(vis_config->instruction_set, vis_get_supported_instruction_set());
+	if(instruction_set == VIS_AVX512)
+	{
+		sample_fourier_transform_over_grid_avx512(group, vis_config, rings, is_first_group);
+		return true;
+	}
+	if(instruction_set == VIS_AVX2)
+	{
+		sample_fourier_transform_over_grid_avx2(group, vis_config, rings, is_first_group);
+		return true;
+	}
+#endif
+	return false;
+}
+
+// see fourier_transform_simd, for sample_fourier_transform_over_grid_fused
+bool fourier_transform_fused_simd(MeshlessDataset* meshless_dataset, VisConfig* vis_config, const SampleRings* rings)
+{
+#ifdef MESHLESS_VIS_HAVE_X86_SIMD
+	VisInstructionSet instruction_set = std::min(vis_config->instruction_set, vis_get_supported_instruction_set());
+	if(instruction_set == VIS_AVX512)
+	{
+		sample_fourier_transform_over_grid_fused_avx512(meshless_dataset, vis_config, rings);
+		return true;
+	}
+	if(instruction_set == VIS_AVX2)
+	{
+		sample_fourier_transform_over_grid_fused_avx2(meshless_dataset, vis_config, rings);
+		return true;
+	}
+#endif
+	return false;
+}
+
+template <bool is_first_group>
+void fourier_transform_group(Group* group, VisConfig* vis_config, const SampleRings* rings)
+{
+	if(vis_config->sampling_method == VIS_NUFFT && fourier_transform_by_nufft_level_1 <is_first_group> (group, vis_config)) return;
+	if(vis_config->sampling_method == VIS_SPECTRUM_SLICE && fourier_transform_by_spectrum_slice_level_1 <is_first_group> (group, vis_config)) return;
+	if(vis_config->sampling_method == VIS_HIERARCHICAL && fourier_transform_by_tree_level_1 <is_first_group> (group, vis_config, rings)) return;
+	if(fourier_transform_simd(group, vis_config, rings, is_first_group)) return;
+
+	if(vis_config->sampling_method == VIS_PHASE_RECURRENCE) fourier_transform_by_recurrence_level_1 <is_first_group> (group, vis_config);
+	else                                                    fourier_transform_level_1 <is_first_group> (group, vis_config, rings);
+}
+
+// the first group's samples replace what was there unless accumulating, the other groups' are always added to them
+void sample_meshless_dataset(MeshlessDataset* meshless_dataset, VisConfig* vis_config, bool accumulate)
+{
+	if (meshless_dataset->number_of_groups < 1) return;
+
+	vis_config_compute_scale(vis_config);
+	update_basis_function_tables(vis_config, meshless_dataset);	// in case the step size changed
+	update_negligible_arguments(vis_config);
+
+	std::vector<int> ring_begin, ring_samples, ring_destinations, tile_begin;
+	std::vector<float> ring_radius;
+	SampleRings rings;
+	build_sample_rings(vis_config, ring_begin, ring_samples, ring_destinations, ring_radius, tile_begin, rings);
+
+	if(!accumulate && vis_config->fuse_groups && vis_config->sampling_method == VIS_DIRECT_SUMMATION && meshless_dataset->number_of_groups > 1)
+	{
+		if(!fourier_transform_fused_simd(meshless_dataset, vis_config, &rings)) sample_fourier_transform_over_grid_fused(*meshless_dataset, *vis_config, rings);
+		return;
+	}
+
+	if(accumulate) fourier_transform_group <false> (meshless_dataset->groups, vis_config, &rings);
+	else           fourier_transform_group <true>  (meshless_dataset->groups, vis_config, &rings);
+	for(int i = 1; i < meshless_dataset->number_of_groups; i++)
+	{
+		fourier_transform_group <false> (meshless_dataset->groups+i, vis_config, &rings);
+	}	
+}
+
+void fourier_transform(MeshlessDataset* meshless_dataset, VisConfig* vis_config)
+{
+	sample_meshless_dataset(meshless_dataset, vis_config, false);
+}
+
+void fourier_transform_accumulate(MeshlessDataset* meshless_dataset, VisConfig* vis_config)
+{
+	sample_meshless_dataset(meshless_dataset, vis_config, true);
+}
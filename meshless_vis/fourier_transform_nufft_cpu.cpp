@@ -0,0 +1,235 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "fourier_transform_nufft_cpu.h"
+#include "meshless_vis.h"
+#include "fft_plans_cpu.h"
+#include <cstring>
+#include <vector>
+
+// the smallest n >= minimum_n with no prime factors other than 2, 3 and 5, which FFTW transforms fastest
+inline int nufft_grid_size(int minimum_n)
+{
+	for(int n = std::max(minimum_n, 2); ; n++)
+	{
+		int m = n;
+		while(m % 2 == 0) m /= 2;
+		while(m % 3 == 0) m /= 3;
+		while(m % 5 == 0) m /= 5;
+		if(m == 1) return n;
+	}
+}
+
+double nufft_kernel_transform(double t, int kernel_width, float beta)
+{
+	// the midpoint rule, the kernel is smooth and vanishes to within exp(-beta) at the ends of its support
+	const int number_of_nodes = 256;
+	double half_width = 0.5*kernel_width;
+	double sum = 0.0;
+	for(int j = 0; j < number_of_nodes; j++)
+	{
+		double z = (j + 0.5)/number_of_nodes;
+		sum += std::exp(beta*(std::sqrt(1.0 - z*z) - 1.0))*std::cos(6.283185307179586476925286766559*t*half_width*z);
+	}
+	return 2.0*sum*half_width/number_of_nodes;	// the kernel is even
+}
+
+// the Fourier transform of the kernel at modes -half_number_of_modes ... half_number_of_modes of a grid of size n
+std::vector<double> nufft_kernel_transforms(int half_number_of_modes, int n, int kernel_width, float beta)
+{
+	std::vector<double> transform(2*half_number_of_modes+1);
+	for(int k = 0; k <= half_number_of_modes; k++) transform[half_number_of_modes+k] = transform[half_number_of_modes-k] = nufft_kernel_transform((double)k/n, kernel_width, beta);
+	return transform;
+}
+
+// The terms are sorted by the first grid row (along the slowest varying dimension) they touch.  The rows are split into an even
+// number of strips at least kernel_width high, so the terms starting in a strip only touch that strip and the next one.  Spreading
+// the even strips and then the odd strips lets each thread own a strip without any atomics or private copies of the grid.
+struct NufftStrips
+{
+	int number_of_strips;
+	std::vector<int> begin, order;
+
+	NufftStrips(int number_of_terms, const float* u, int n, int kernel_width)
+	: number_of_strips(2*std::max(1, n/(2*kernel_width))), begin(number_of_strips+1, 0), order(number_of_terms)
+	{
+		int strip_height = n/number_of_strips;
+		std::vector<int> strip(number_of_terms);
+
+		#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+		for(int k = 0; k < number_of_terms; k++)
+		{
+			int first = (int)std::ceil((u[k] - std::floor(u[k]))*n - 0.5f*kernel_width);
+			strip[k] = std::min(((first + n) % n)/strip_height, number_of_strips-1);
+		}
+		for(int k = 0; k < number_of_terms; k++) begin[strip[k]+1]++;
+		for(int s = 0; s < number_of_strips; s++) begin[s+1] += begin[s];
+		std::vector<int> position(begin.begin(), begin.end()-1);
+		for(int k = 0; k < number_of_terms; k++) order[position[strip[k]]++] = k;
+	}
+};
+
+void nufft_type_1(int number_of_terms, const float* u, const float* v, const float* weights, int first_mode_u, int number_of_modes_u, int number_of_modes_v, float tolerance, fftwf_complex* modes)
+{
+	int kernel_width = nufft_kernel_width(tolerance);
+	float beta = nufft_kernel_beta(kernel_width);
+
+	int half_modes_u = std::max(-first_mode_u, first_mode_u + number_of_modes_u - 1);
+	int half_modes_v = number_of_modes_v - 1;
+	int n_u = nufft_grid_size(std::max(nufft_oversampling*(2*half_modes_u+1), 2*kernel_width));
+	int n_v = nufft_grid_size(std::max(nufft_oversampling*(2*half_modes_v+1), 2*kernel_width));
+
+	fftwf_complex* grid = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*n_u*n_v);
+	fftwf_plan plan = fft_plan_dft_2d(n_v, n_u, grid, FFTW_BACKWARD);
+	memset(grid, 0, sizeof(fftwf_complex)*n_u*n_v);
+
+	NufftStrips strips(number_of_terms, v, n_v, kernel_width);
+
+	for(int parity = 0; parity < 2; parity++)
+	{
+		#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+		{
+			float kernel_u[nufft_max_kernel_width], kernel_v[nufft_max_kernel_width];
+			int column[nufft_max_kernel_width];
+
+			#pragma omp for schedule(dynamic,1)
+			for(int s = parity; s < strips.number_of_strips; s += 2)
+			{
+				for(int j = strips.begin[s]; j < strips.begin[s+1]; j++)
+				{
+					int k = strips.order[j];
+					if(weights[k] == 0.0f) continue;
+
+					int first_u, first_v;
+					nufft_evaluate_kernel((u[k] - std::floor(u[k]))*n_u, kernel_width, beta, first_u, kernel_u);
+					nufft_evaluate_kernel((v[k] - std::floor(v[k]))*n_v, kernel_width, beta, first_v, kernel_v);
+					for(int i = 0; i < kernel_width; i++) column[i] = (first_u + i + n_u) % n_u, kernel_u[i] *= weights[k];
+
+					for(int l = 0; l < kernel_width; l++)
+					{
+						fftwf_complex* row = grid + ((first_v + l + n_v) % n_v)*n_u;
+						for(int i = 0; i < kernel_width; i++) row[column[i]][0] += kernel_u[i]*kernel_v[l];
+					}
+				}
+			}
+		}
+	}
+
+	fftwf_execute(plan);
+
+	// deconvolve, the weights are real so only the real part of the grid was spread into
+	std::vector<double> transform_u = nufft_kernel_transforms(half_modes_u, n_u, kernel_width, beta);
+	std::vector<double> transform_v = nufft_kernel_transforms(half_modes_v, n_v, kernel_width, beta);
+
+	#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+	for(int y = 0; y < number_of_modes_v; y++)
+	{
+		for(int i = 0; i < number_of_modes_u; i++)
+		{
+			int x = first_mode_u + i;
+			const fftwf_complex& g = grid[y*n_u + (x + n_u) % n_u];
+			float scale = (float)(1.0/(transform_u[half_modes_u+x]*transform_v[half_modes_v+y]));
+			modes[y*number_of_modes_u + i][0] = g[0]*scale, modes[y*number_of_modes_u + i][1] = g[1]*scale;
+		}
+	}
+
+	fft_destroy_plan(plan);
+	fftwf_free(grid);
+}
+
+void nufft_type_1_3d(int number_of_terms, const float* u, const float* v, const float* w, const float* weights, const int* half_number_of_modes, float tolerance, fftwf_complex* modes)
+{
+	int kernel_width = nufft_kernel_width(tolerance);
+	float beta = nufft_kernel_beta(kernel_width);
+
+	int n[3];
+	for(int d = 0; d < 3; d++) n[d] = nufft_grid_size(std::max(nufft_oversampling*(2*half_number_of_modes[d]+1), 2*kernel_width));
+
+	// the grid is real, so it is transformed in place with a real to complex transform, which pads the last dimension
+	int padded_n_2 = 2*(n[2]/2+1);
+	float* grid = (float*)fftwf_malloc(sizeof(float)*n[0]*n[1]*padded_n_2);
+	fftwf_plan plan = fft_plan_dft_r2c_3d(n[0], n[1], n[2], grid);
+	memset(grid, 0, sizeof(float)*n[0]*n[1]*padded_n_2);
+
+	NufftStrips strips(number_of_terms, u, n[0], kernel_width);
+
+	for(int parity = 0; parity < 2; parity++)
+	{
+		#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+		{
+			float kernel_u[nufft_max_kernel_width], kernel_v[nufft_max_kernel_width], kernel_w[nufft_max_kernel_width];
+			int column[nufft_max_kernel_width];
+
+			#pragma omp for schedule(dynamic,1)
+			for(int s = parity; s < strips.number_of_strips; s += 2)
+			{
+				for(int j = strips.begin[s]; j < strips.begin[s+1]; j++)
+				{
+					int k = strips.order[j];
+					if(weights[k] == 0.0f) continue;
+
+					int first_u, first_v, first_w;
+					nufft_evaluate_kernel((u[k] - std::floor(u[k]))*n[0], kernel_width, beta, first_u, kernel_u);
+					nufft_evaluate_kernel((v[k] - std::floor(v[k]))*n[1], kernel_width, beta, first_v, kernel_v);
+					nufft_evaluate_kernel((w[k] - std::floor(w[k]))*n[2], kernel_width, beta, first_w, kernel_w);
+					for(int i = 0; i < kernel_width; i++) column[i] = (first_w + i + n[2]) % n[2], kernel_w[i] *= weights[k];
+
+					for(int a = 0; a < kernel_width; a++)
+					{
+						for(int b = 0; b < kernel_width; b++)
+						{
+							float* row = grid + ((long)((first_u + a + n[0]) % n[0])*n[1] + (first_v + b + n[1]) % n[1])*padded_n_2;
+							float kernel_uv = kernel_u[a]*kernel_v[b];
+							for(int i = 0; i < kernel_width; i++) row[column[i]] += kernel_uv*kernel_w[i];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	fftwf_execute(plan);
+
+	// deconvolve, FFTW's forward transform has the opposite sign so we also take the complex conjugate
+	std::vector<double> transform[3];
+	for(int d = 0; d < 3; d++) transform[d] = nufft_kernel_transforms(half_number_of_modes[d], n[d], kernel_width, beta);
+	fftwf_complex* transformed_grid = (fftwf_complex*)grid;
+	int number_of_modes_y = 2*half_number_of_modes[1]+1, number_of_modes_z = half_number_of_modes[2]+1;
+
+	#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+	for(int x = -half_number_of_modes[0]; x <= half_number_of_modes[0]; x++)
+	{
+		for(int y = -half_number_of_modes[1]; y <= half_number_of_modes[1]; y++)
+		{
+			const fftwf_complex* row = transformed_grid + ((long)((x + n[0]) % n[0])*n[1] + (y + n[1]) % n[1])*(n[2]/2+1);
+			fftwf_complex* mode = modes + ((long)(x + half_number_of_modes[0])*number_of_modes_y + y + half_number_of_modes[1])*number_of_modes_z;
+			double transform_xy = transform[0][half_number_of_modes[0]+x]*transform[1][half_number_of_modes[1]+y];
+			for(int z = 0; z < number_of_modes_z; z++)
+			{
+				float scale = (float)(1.0/(transform_xy*transform[2][half_number_of_modes[2]+z]));
+				mode[z][0] = row[z][0]*scale, mode[z][1] = -row[z][1]*scale;
+			}
+		}
+	}
+
+	fft_destroy_plan(plan);
+	fftwf_free(grid);
+}
@@ -0,0 +1,75 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FOURIER_TRANSFORM_NUFFT_CPU_H_
+#define FOURIER_TRANSFORM_NUFFT_CPU_H_
+
+#include <fftw3.h>
+#include <cmath>
+#include <algorithm>
+
+// The terms are spread onto a grid oversampled by nufft_oversampling with the "exponential of semicircle" kernel
+// exp(beta (sqrt(1 - z^2) - 1)), |z| <= 1, stretched over kernel_width grid points.  The grid is transformed with FFTW and
+// each mode is divided by the Fourier transform of the kernel to undo the spreading.  This is the scheme used by FINUFFT,
+// see Barnett, Magland and af Klinteberg, "A parallel non-uniform fast Fourier transform library based on an
+// "exponential of semicircle" kernel", SIAM J. Sci. Comput. 41 (2019).
+
+const int nufft_oversampling = 2;
+const int nufft_max_kernel_width = 16;
+
+inline int nufft_kernel_width(float tolerance)
+{
+	int kernel_width = (int)std::ceil(-std::log10(std::max(tolerance, 1.0e-7f))) + 1;
+	return std::max(2, std::min(kernel_width, nufft_max_kernel_width));
+}
+
+inline float nufft_kernel_beta(int kernel_width) { return 2.30f*kernel_width; }
+
+// fills kernel with the kernel at the kernel_width grid points starting at first, for a point at grid coordinate g
+inline void nufft_evaluate_kernel(float g, int kernel_width, float beta, int& first, float* kernel)
+{
+	float half_width = 0.5f*kernel_width;
+	first = (int)std::ceil(g - half_width);
+	for(int i = 0; i < kernel_width; i++)
+	{
+		float z = (first + i - g)/half_width;
+		kernel[i] = std::exp(beta*(std::sqrt(std::max(0.0f, 1.0f - z*z)) - 1.0f));
+	}
+}
+
+// the Fourier transform of the kernel, in grid units, at t cycles per grid point
+double nufft_kernel_transform(double t, int kernel_width, float beta);
+
+// A type 1 non-uniform FFT.  Computes
+//
+//     modes[y*number_of_modes_u + x - first_mode_u] = sum_k weights[k] exp(2 pi i (x u[k] + y v[k]))
+//
+// for first_mode_u <= x < first_mode_u + number_of_modes_u and 0 <= y < number_of_modes_v, where u and v are in turns.  The error
+// relative to sum_k |weights[k]| is roughly tolerance (down to about 1e-6, the limit of single precision).
+void nufft_type_1(int number_of_terms, const float* u, const float* v, const float* weights, int first_mode_u, int number_of_modes_u, int number_of_modes_v, float tolerance, fftwf_complex* modes);
+
+// The same in three dimensions, for |x| <= half_number_of_modes[0], |y| <= half_number_of_modes[1] and 0 <= z <= half_number_of_modes[2]
+// (the weights are real, so the other half is the complex conjugate), stored at
+//
+//     modes[((x + half_number_of_modes[0])*(2*half_number_of_modes[1]+1) + y + half_number_of_modes[1])*(half_number_of_modes[2]+1) + z]
+void nufft_type_1_3d(int number_of_terms, const float* u, const float* v, const float* w, const float* weights, const int* half_number_of_modes, float tolerance, fftwf_complex* modes);
+
+#endif /*FOURIER_TRANSFORM_NUFFT_CPU_H_*/
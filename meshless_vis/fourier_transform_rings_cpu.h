@@ -0,0 +1,79 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FOURIER_TRANSFORM_RINGS_CPU_H_
+#define FOURIER_TRANSFORM_RINGS_CPU_H_
+
+#include "meshless.h"
+#include "meshless_vis.h"
+
+// The basis functions only depend on the distance r of a sample from the origin, so the direct summation kernels walk the samples
+// of _d_freq_image one ring of equal r at a time and evaluate the basis function once per ring and term.  With equal step sizes a
+// ring is every (x, y) with the same x^2 + y^2, otherwise it is only x and -x.
+// Consecutive rings are grouped into tiles of at least vis_config->tile_samples samples, which the kernels sum over
+// vis_config->tile_terms terms at a time, so that each chunk of terms is read from memory once per tile instead of once per ring.
+struct SampleRings
+{
+	int number_of_rings;
+	const int* begin;		// ring i holds samples[begin[i]] ... samples[begin[i+1]-1]
+	const int* samples;		// indices into _d_freq_image, which give the samples' coordinates
+	const float* radius;
+
+	// the kernels write sample samples[i] to image[destinations[i]], image is _d_freq_image_arranged when the samples are arranged in
+	// the kernels (which then skip the column at x = cutoff_frequency.x that arrange_samples drops), otherwise _d_freq_image
+	fftwf_complex* image;
+	const int* destinations;
+
+	int number_of_tiles;
+	int largest_tile;		// in samples
+	int most_rings_per_tile;
+	const int* tile_begin;	// tile i holds rings tile_begin[i] ... tile_begin[i+1]-1
+};
+
+// where the kernels that don't use rings write the sample at (x, y), for 1-cutoff_frequency.x <= x <= cutoff_frequency.x, or 0 if it
+// isn't kept
+inline fftwf_complex* sample_destination(const VisConfig& vis_config, int x, int y)
+{
+	if(!vis_config._arrange_samples_in_kernels) return vis_config._d_freq_image + y*2*vis_config._cutoff_frequency.x + (x < 0 ? x + 2*vis_config._cutoff_frequency.x : x);
+	if(x == vis_config._cutoff_frequency.x) return 0;
+	return vis_config._d_freq_image_arranged + (x < 0 ? x + vis_config._number_of_samples.x : x)*(vis_config._number_of_samples.y/2+1) + y;
+}
+
+// The terms are sorted by increasing radius when they're registered, so the ones whose basis function is still significant at
+// distance r from the origin, those with r*radius below negligible_argument (see vis_config->basis_function_epsilon), come first.
+// Returns how many there are, a negligible_argument of 0 keeps them all.
+inline int number_of_contributing_terms(const Group& group, float negligible_argument, float r)
+{
+	if(negligible_argument <= 0.0f) return group.d_number_of_terms;
+	if(group.d_radii == 0) return r < negligible_argument ? group.d_number_of_terms : 0;
+	if(group.number_of_terms == 0 || r*group.d_radii[group.number_of_terms-1] < negligible_argument) return group.d_number_of_terms;
+
+	int low = 0, high = group.number_of_terms;
+	while(low < high)
+	{
+		int middle = (low + high)/2;
+		if(r*group.d_radii[middle] < negligible_argument) low = middle + 1;
+		else                                              high = middle;
+	}
+	return low;
+}
+
+#endif /*FOURIER_TRANSFORM_RINGS_CPU_H_*/
@@ -0,0 +1,43 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FOURIER_TRANSFORM_SIMD_CPU_H_
+#define FOURIER_TRANSFORM_SIMD_CPU_H_
+
+#include "meshless_vis.h"
+#include "meshless.h"
+#include "fourier_transform_rings_cpu.h"
+#include "fourier_transform_tables_cpu.h"
+#include "memory_cpu.h"
+#include "work_stealing_cpu.h"
+
+// the vectorized kernels are written with gcc vector extensions, each instruction set is compiled in its own translation unit
+// with the matching -m flags (see makefile_cpu) and only ever called after checking the processor supports it
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && (defined(__x86_64__) || defined(__i386__))
+#define MESHLESS_VIS_HAVE_X86_SIMD
+#endif
+
+void sample_fourier_transform_over_grid_avx2(Group* group, VisConfig* vis_config, const SampleRings* rings, bool is_first_group);
+void sample_fourier_transform_over_grid_avx512(Group* group, VisConfig* vis_config, const SampleRings* rings, bool is_first_group);
+void sample_fourier_transform_over_grid_fused_avx2(MeshlessDataset* meshless_dataset, VisConfig* vis_config, const SampleRings* rings);
+void sample_fourier_transform_over_grid_fused_avx512(MeshlessDataset* meshless_dataset, VisConfig* vis_config, const SampleRings* rings);
+
+#endif /*FOURIER_TRANSFORM_SIMD_CPU_H_*/
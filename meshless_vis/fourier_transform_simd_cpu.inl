@@ -0,0 +1,651 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// This is the body of the vectorized CPU kernel.  It is included by one translation unit per instruction set, which first defines
+// MESHLESS_VIS_SIMD_WIDTH (the number of floats per register), MESHLESS_VIS_SIMD_ENTRY and MESHLESS_VIS_SIMD_FUSED_ENTRY (the names
+// of the entry points).
+// Everything except the entry points has internal linkage, so that nothing compiled with the wider instruction set can be picked
+// up by the linker for the scalar code.  For the same reason no standard library headers are included here.
+
+namespace
+{
+
+typedef float vfloat __attribute__((vector_size(4*MESHLESS_VIS_SIMD_WIDTH)));
+typedef int   vint   __attribute__((vector_size(4*MESHLESS_VIS_SIMD_WIDTH)));
+typedef float vfloat_unaligned __attribute__((vector_size(4*MESHLESS_VIS_SIMD_WIDTH), aligned(4)));
+
+const int simd_width = MESHLESS_VIS_SIMD_WIDTH;
+const float simd_pi = 3.141592653589793238462643383279f;
+
+inline vfloat broadcast(float a) { return vfloat() + a; }
+inline vfloat load(const float* p) { return *(const vfloat_unaligned*)p; }
+inline vfloat blend(vint mask, vfloat a, vfloat b) { return (vfloat)(((vint)a & mask) | ((vint)b & ~mask)); }
+
+inline vfloat round_to_integer(vfloat x, vint& i)
+{
+	// adding 1.5*2^23 pushes the fraction out of the mantissa, leaving round(x) as an integer in the low bits (valid for |x| < 2^22)
+	const vfloat magic = broadcast(12582912.0f);
+	vfloat shifted = x + magic;
+	i = (vint)shifted - (vint)magic;
+	return shifted - magic;
+}
+
+// sin(2 pi t) and cos(2 pi t).  the argument is reduced by whole quarter turns so the polynomials (from cephes) only see [-pi/4, pi/4]
+inline void sincos_turns(vfloat t, vfloat& s, vfloat& c)
+{
+	vint quadrant;
+	vfloat quarter_turns = 4.0f*t;
+	vfloat x = (quarter_turns - round_to_integer(quarter_turns, quadrant))*1.5707963267948966f;
+	vfloat x_2 = x*x;
+	vfloat sin_x = x + x*x_2*(-1.6666654611e-1f + x_2*(8.3321608736e-3f + x_2*(-1.9515295891e-4f)));
+	vfloat cos_x = 1.0f - 0.5f*x_2 + x_2*x_2*(4.166664568298827e-2f + x_2*(-1.388731625493765e-3f + x_2*2.443315711809948e-5f));
+
+	vint swap = -(quadrant & 1);
+	s = blend(swap, cos_x, sin_x);
+	c = blend(swap, sin_x, cos_x);
+	s = (vfloat)((vint)s ^ ((quadrant & 2) << 30));
+	c = (vfloat)((vint)c ^ (((quadrant + 1) & 2) << 30));
+}
+
+inline vfloat vector_exp(vfloat x)
+{
+	x = blend(x > broadcast(88.37626f), broadcast(88.37626f), x);
+	x = blend(x < broadcast(-87.33654f), broadcast(-87.33654f), x);
+
+	vint n;
+	vfloat fn = round_to_integer(x*1.44269504088896341f, n);
+	x = x - fn*0.693359375f - fn*(-2.12194440e-4f);
+	vfloat y = (((((1.9875691500e-4f*x + 1.3981999507e-3f)*x + 8.3334519073e-3f)*x + 4.1665795894e-2f)*x + 1.6666665459e-1f)*x + 5.0000001201e-1f)*x*x + x + 1.0f;
+	return y*(vfloat)((n + 127) << 23);
+}
+
+// these match fourier_transform_sph etc. in fourier_transform_cpu.cpp, both branches are evaluated and the right one is selected per lane
+template <BasisFunctionId basis_function_id>
+inline vfloat basis_function(vfloat r)
+{
+	if(basis_function_id == GAUSSIAN) return vector_exp(simd_pi*r*r);
+
+	vfloat m = simd_pi*r;
+	vfloat sin_2_m, cos_2_m;
+	sincos_turns(r, sin_2_m, cos_2_m);	// 2m is r turns
+	if(basis_function_id == SPH)
+	{
+		vfloat m_3 = m*m*m;
+		vfloat outer = (2.3561944901923448f/(m_3*m_3))*(cos_2_m-1.0f)*(cos_2_m+m*sin_2_m-1.0f);
+		vfloat inner = simd_pi + r*(-0.007968913156311f + r*(-18.293608272337678f));
+		return blend(r >= broadcast(0.06f), outer, inner);
+	}
+	else
+	{
+		vfloat m_2 = m*m;
+		vfloat m_4 = m_2*m_2;
+		vfloat outer = ((simd_pi*7.5f)/(m_4*m_4))*(4.0f*m_2 - 6.0f + (6.0f-m_2)*cos_2_m+4.5f*m*sin_2_m);
+		vfloat inner = 0.299199300341890f + r*(-0.002379178586124f + r*(-0.370530218163545f));
+		return blend(r >= broadcast(0.24f), outer, inner);
+	}
+}
+
+// the tabulated transforms, see fourier_transform_tables_cpu.h, with each coefficient gathered straight into the lanes
+inline vfloat gather(const float* table, vint i)
+{
+#if MESHLESS_VIS_SIMD_WIDTH == 16
+	return __builtin_ia32_gathersiv16sf(vfloat(), table, i, (unsigned short)0xffff, 4);
+#else
+	return __builtin_ia32_gathersiv8sf(vfloat(), table, i, (vfloat)(vint() - 1), 4);
+#endif
+}
+
+inline vfloat basis_function_table_lookup(const BasisFunctionTable* table, vfloat r)
+{
+	vint i;
+	vfloat last = broadcast((float)(table->number_of_intervals-1));
+	vfloat t = r*table->intervals_per_unit;
+	vfloat first = round_to_integer(t - 0.5f, i);	// floor(t), or t-1 when t is whole, where both cubics agree
+	first = blend(first < vfloat(), vfloat(), blend(first > last, last, first));
+	round_to_integer(first, i);
+	t -= first;
+	return gather(table->coefficients[0], i) + t*(gather(table->coefficients[1], i) + t*(gather(table->coefficients[2], i) + t*gather(table->coefficients[3], i)));
+}
+
+template <BasisFunctionId basis_function_id>
+inline vfloat basis_function(const VisConfig& vis_config, vfloat r)
+{
+	const BasisFunctionTable* table = vis_config._basis_function_tables[basis_function_id];
+	return table ? basis_function_table_lookup(table, r) : basis_function<basis_function_id>(r);
+}
+
+// fftwf_malloc only guarantees the alignment FFTW itself was built for, which may be narrower than a register
+struct VectorBuffer
+{
+	void* memory;
+	vfloat* data;
+
+	VectorBuffer(int number_of_vectors)
+	{
+		memory = fftwf_malloc((number_of_vectors+1)*sizeof(vfloat));
+		data = (vfloat*)(((__UINTPTR_TYPE__)memory + sizeof(vfloat) - 1) & ~(__UINTPTR_TYPE__)(sizeof(vfloat) - 1));
+	}
+	~VectorBuffer() { fftwf_free(memory); }
+};
+
+// scales the sums of a tile's samples, sums[2*i] and sums[2*i+1] for the i-th, and writes them out
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii>
+void write_tile_simd(const VisConfig& vis_config, const SampleRings& rings, int tile, const float* sums)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	const int* destinations = rings.destinations + rings.begin[first_ring];
+	for(int ring = first_ring; ring < last_ring; ring++)
+	{
+		float scale = vis_config._scale;
+		if(!has_radii) scale *= basis_function<basis_function_id>(vis_config, broadcast(rings.radius[ring]))[0];
+
+		for(int i = rings.begin[ring] - rings.begin[first_ring]; i < rings.begin[ring+1] - rings.begin[first_ring]; i++)
+		{
+			if(is_first_group)
+			{
+				rings.image[destinations[i]][0]  = sums[2*i]*scale, rings.image[destinations[i]][1]  = -sums[2*i+1]*scale;
+			}
+			else
+			{
+				rings.image[destinations[i]][0] += sums[2*i]*scale, rings.image[destinations[i]][1] += -sums[2*i+1]*scale;
+			}
+		}
+	}
+}
+
+// see reduce_partial_sums in fourier_transform_cpu.cpp, here partial_sums and tile_sums hold pairs of floats
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii>
+void reduce_partial_sums_simd(const VisConfig& vis_config, const SampleRings& rings, const float* partial_sums, int number_of_partitions, float* tile_sums)
+{
+	int number_of_ring_samples = rings.begin[rings.number_of_rings];
+
+	#pragma omp barrier
+	#pragma omp for schedule(dynamic,1) nowait
+	for(int tile = 0; tile < rings.number_of_tiles; tile++)
+	{
+		int begin = rings.begin[rings.tile_begin[tile]], end = rings.begin[rings.tile_begin[tile+1]];
+		for(int i = begin; i < end; i++)
+		{
+			float real = partial_sums[2*i], imag = partial_sums[2*i+1];
+			for(int partition = 1; partition < number_of_partitions; partition++)
+			{
+				real += partial_sums[2*(partition*number_of_ring_samples + i)], imag += partial_sums[2*(partition*number_of_ring_samples + i)+1];
+			}
+			tile_sums[2*(i-begin)] = real, tile_sums[2*(i-begin)+1] = imag;
+		}
+		write_tile_simd<is_first_group, basis_function_id, has_radii>(vis_config, rings, tile, tile_sums);
+	}
+}
+
+// adds up the lanes of each sample's sums, into sums[2*i] and sums[2*i+1]
+inline void reduce_lanes(int number_of_samples, const vfloat* sum_real, const vfloat* sum_imag, float* sums)
+{
+	for(int i = 0; i < number_of_samples; i++)
+	{
+		float real = 0.0f, imag = 0.0f;
+		for(int j = 0; j < simd_width; j++) real += sum_real[i][j], imag += sum_imag[i][j];
+		sums[2*i] = real, sums[2*i+1] = imag;
+	}
+}
+
+// maps a tile's samples from image space into frequency space, f_coord[3*i] ... f_coord[3*i+2] for the i-th
+inline void tile_coordinates_simd(const VisConfig& vis_config, const SampleRings& rings, int tile, float* f_coord)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	const int* samples = rings.samples + rings.begin[first_ring];
+	int number_of_samples = rings.begin[last_ring] - rings.begin[first_ring];
+	for(int i = 0; i < number_of_samples; i++)
+	{
+		int x = samples[i] % (2*vis_config._cutoff_frequency.x);
+		if(x > vis_config._cutoff_frequency.x) x = x-(2*vis_config._cutoff_frequency.x);
+		int y = samples[i] / (2*vis_config._cutoff_frequency.x);
+
+		// map from image space into frequency space
+		float fu = vis_config.step_size.x*x, fv = vis_config.step_size.y*y;
+		f_coord[3*i+0] = fu*vis_config.u_axis.x + fv*vis_config.v_axis.x;
+		f_coord[3*i+1] = fu*vis_config.u_axis.y + fv*vis_config.v_axis.y;
+		f_coord[3*i+2] = fu*vis_config.u_axis.z + fv*vis_config.v_axis.z;
+	}
+}
+
+// ring_basis[(ring-first_ring)*padded_number_of_distinct_radii + d] for the group's tabulated radii
+template <BasisFunctionId basis_function_id>
+void tabulate_ring_basis_simd(const Group& group, const VisConfig& vis_config, const SampleRings& rings, int tile, int padded_number_of_distinct_radii, float* ring_basis)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	for(int ring = first_ring; ring < last_ring; ring++)
+	{
+		float* basis = ring_basis + (ring-first_ring)*padded_number_of_distinct_radii;
+		for(int d = 0; d < group.number_of_distinct_radii; d += simd_width)
+		{
+			int number_of_lanes = group.number_of_distinct_radii - d < simd_width ? group.number_of_distinct_radii - d : simd_width;
+			vfloat distinct_radii = vfloat();
+			for(int j = 0; j < number_of_lanes; j++) distinct_radii[j] = group.d_distinct_radii[d+j];
+			vfloat ring_basis_d = basis_function<basis_function_id>(vis_config, rings.radius[ring]*distinct_radii);
+			for(int j = 0; j < number_of_lanes; j++) basis[d+j] = ring_basis_d[j];
+		}
+	}
+}
+
+inline int pad_to_simd_width(int n) { return simd_width*((n + simd_width - 1)/simd_width); }
+
+// the terms that don't fill a whole register are copied into zero padded arrays, the padding has zero weight so it doesn't contribute anything
+struct GroupTail
+{
+	int number_of_full_vectors, number_of_vectors;
+	float x[MESHLESS_VIS_SIMD_WIDTH], y[MESHLESS_VIS_SIMD_WIDTH], z[MESHLESS_VIS_SIMD_WIDTH];
+	float weights[MESHLESS_VIS_SIMD_WIDTH], radii[MESHLESS_VIS_SIMD_WIDTH];
+	int radius_indices[MESHLESS_VIS_SIMD_WIDTH];
+
+	GroupTail() {}
+	GroupTail(const Group& group)
+	{
+		number_of_full_vectors = group.d_number_of_terms / simd_width;
+		int number_of_remaining_terms = group.d_number_of_terms % simd_width;
+		number_of_vectors = number_of_full_vectors + (number_of_remaining_terms > 0);
+		for(int k = 0, j = number_of_full_vectors*simd_width; k < simd_width; k++, j++)
+		{
+			bool is_term = k < number_of_remaining_terms;
+			x[k] = is_term ? group.d_x[j] : 0.0f, y[k] = is_term ? group.d_y[j] : 0.0f, z[k] = is_term ? group.d_z[j] : 0.0f;
+			weights[k] = is_term ? group.d_weights[j] : 0.0f;
+			radii[k] = is_term && group.d_radii ? group.d_radii[j] : 0.0f;
+			radius_indices[k] = is_term && group.d_radius_indices ? group.d_radius_indices[j] : 0;
+		}
+	}
+};
+
+// adds vectors first_vector ... end_vector-1 of the group's terms to the sums of the tile's samples, vectors_per_chunk at a time
+template <BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void sum_tile_simd(const Group& group, const GroupTail& tail, const VisConfig& vis_config, const SampleRings& rings, int tile, int first_vector, int end_vector, int vectors_per_chunk,
+	const float* f_coord, const float* ring_basis, vfloat* sum_real, vfloat* sum_imag)
+{
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	int padded_number_of_distinct_radii = pad_to_simd_width(group.number_of_distinct_radii);
+
+	// each chunk of terms is reused from cache by every ring of the tile
+	for(int chunk = first_vector; chunk < end_vector; chunk += vectors_per_chunk)
+	{
+		int chunk_end = chunk + vectors_per_chunk < end_vector ? chunk + vectors_per_chunk : end_vector;
+		for(int ring = first_ring; ring < last_ring; ring++)
+		{
+			float r = rings.radius[ring];
+			int first = rings.begin[ring] - rings.begin[first_ring], last = rings.begin[ring+1] - rings.begin[first_ring];
+			const float* basis = ring_basis + (ring-first_ring)*padded_number_of_distinct_radii;
+			int last_vector = (number_of_contributing_terms(group, vis_config._negligible_argument[basis_function_id], r) + simd_width - 1)/simd_width;
+			if(last_vector > chunk_end) last_vector = chunk_end;
+
+			for(int v = chunk; v < last_vector; v++)
+			{
+				bool is_tail = v == tail.number_of_full_vectors;
+				int k = v*simd_width;
+				vfloat p_x = load(is_tail ? tail.x : group.d_x+k), p_y = load(is_tail ? tail.y : group.d_y+k), p_z = load(is_tail ? tail.z : group.d_z+k);
+
+				// without radii the basis function is the same for every term, so it's applied when the sums are written out
+				vfloat term = load(is_tail ? tail.weights : group.d_weights+k);
+				if(tabulated_radii)
+				{
+					const int* radius_indices = is_tail ? tail.radius_indices : group.d_radius_indices+k;
+					vfloat looked_up;
+					for(int j = 0; j < simd_width; j++) looked_up[j] = basis[radius_indices[j]];
+					term *= looked_up;
+				}
+				else if(has_radii) term *= basis_function<basis_function_id>(vis_config, r*load(is_tail ? tail.radii : group.d_radii+k));
+
+				for(int i = first; i < last; i++)
+				{
+					vfloat sin_v, cos_v;
+					sincos_turns(f_coord[3*i]*p_x + f_coord[3*i+1]*p_y + f_coord[3*i+2]*p_z, sin_v, cos_v);
+					sum_real[i] += term*cos_v;
+					sum_imag[i] += term*sin_v;
+				}
+			}
+		}
+	}
+}
+
+// see sample_fourier_transform_over_grid in fourier_transform_cpu.cpp, here each lane holds one term
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void sample_fourier_transform_over_grid_simd(Group group, VisConfig vis_config, SampleRings rings)
+{
+	GroupTail tail(group);
+	int vectors_per_chunk = vis_config.tile_terms > simd_width ? vis_config.tile_terms/simd_width : 1;
+	int number_of_chunks = (tail.number_of_vectors + vectors_per_chunk - 1)/vectors_per_chunk;
+	int number_of_partitions = number_of_term_partitions(vis_config, rings.number_of_tiles, number_of_chunks);
+
+	// partial_sums[2*(partition*number_of_ring_samples + i)] and the next float for the i-th sample of the rings
+	int number_of_ring_samples = rings.begin[rings.number_of_rings];
+	float* partial_sums = number_of_partitions > 1 ? (float*)fftwf_malloc(2*sizeof(float)*number_of_partitions*number_of_ring_samples) : 0;
+	WorkStealingTasks tasks(rings.number_of_tiles*number_of_partitions, vis_get_number_of_threads());
+
+	// see sample_fourier_transform_over_grid in fourier_transform_cpu.cpp
+	const Group& shared_group = group;
+	#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+	{
+		const Group& group = node_local_group(shared_group);
+		VectorBuffer sums(2*rings.largest_tile);
+		vfloat* sum_real = sums.data, *sum_imag = sums.data + rings.largest_tile;
+		float* tile_sums = (float*)fftwf_malloc(2*rings.largest_tile*sizeof(float));
+		float* f_coord = (float*)fftwf_malloc(3*rings.largest_tile*sizeof(float));
+		int padded_number_of_distinct_radii = pad_to_simd_width(group.number_of_distinct_radii);
+		float* ring_basis = (float*)fftwf_malloc((padded_number_of_distinct_radii*rings.most_rings_per_tile+1)*sizeof(float));
+
+		int task, current_tile = -1;
+		while(tasks.next(task))
+		{
+			int tile = task/number_of_partitions, partition = task%number_of_partitions;
+			int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+			int number_of_samples = rings.begin[last_ring] - rings.begin[first_ring];
+			if(tile != current_tile)
+			{
+				tile_coordinates_simd(vis_config, rings, tile, f_coord);
+				if(tabulated_radii) tabulate_ring_basis_simd<basis_function_id>(group, vis_config, rings, tile, padded_number_of_distinct_radii, ring_basis);
+				current_tile = tile;
+			}
+			for(int i = 0; i < number_of_samples; i++) sum_real[i] = sum_imag[i] = vfloat();
+
+			int first_vector = vectors_per_chunk*(int)((long long)number_of_chunks*partition/number_of_partitions);
+			int end_vector = vectors_per_chunk*(int)((long long)number_of_chunks*(partition+1)/number_of_partitions);
+			if(end_vector > tail.number_of_vectors) end_vector = tail.number_of_vectors;
+			sum_tile_simd<basis_function_id, has_radii, tabulated_radii>(group, tail, vis_config, rings, tile, first_vector, end_vector, vectors_per_chunk, f_coord, ring_basis, sum_real, sum_imag);
+
+			if(number_of_partitions == 1)
+			{
+				reduce_lanes(number_of_samples, sum_real, sum_imag, tile_sums);
+				write_tile_simd<is_first_group, basis_function_id, has_radii>(vis_config, rings, tile, tile_sums);
+			}
+			else reduce_lanes(number_of_samples, sum_real, sum_imag, partial_sums + 2*(partition*number_of_ring_samples + rings.begin[first_ring]));
+		}
+
+		if(number_of_partitions > 1) reduce_partial_sums_simd<is_first_group, basis_function_id, has_radii>(vis_config, rings, partial_sums, number_of_partitions, tile_sums);
+
+		fftwf_free(ring_basis);
+		fftwf_free(f_coord);
+		fftwf_free(tile_sums);
+
+		// GCC can miss a path out of the task loop with the upper halves of the registers still dirty, which then makes the scalar
+		// code that follows on this thread (the scalar kernels, FFTW) many times slower
+		__builtin_ia32_vzeroupper();
+	}
+	fftwf_free(partial_sums);
+}
+
+// see sample_fourier_transform_over_grid_fused in fourier_transform_cpu.cpp.  Groups with radii add straight into the tile's sums,
+// the others into group_real and group_imag first, to apply their basis function ring by ring.
+typedef void (*GroupTileSumSIMD)(const Group& group, const GroupTail& tail, const VisConfig& vis_config, const SampleRings& rings, int tile, int first_vector, int end_vector,
+	const float* f_coord, float* ring_basis, vfloat* group_real, vfloat* group_imag, vfloat* sum_real, vfloat* sum_imag);
+
+template <BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void add_group_tile_sum_simd(const Group& group, const GroupTail& tail, const VisConfig& vis_config, const SampleRings& rings, int tile, int first_vector, int end_vector,
+	const float* f_coord, float* ring_basis, vfloat* group_real, vfloat* group_imag, vfloat* sum_real, vfloat* sum_imag)
+{
+	int vectors_per_chunk = vis_config.tile_terms > simd_width ? vis_config.tile_terms/simd_width : 1;
+	if(tabulated_radii) tabulate_ring_basis_simd<basis_function_id>(group, vis_config, rings, tile, pad_to_simd_width(group.number_of_distinct_radii), ring_basis);
+	if(has_radii)
+	{
+		sum_tile_simd<basis_function_id, has_radii, tabulated_radii>(group, tail, vis_config, rings, tile, first_vector, end_vector, vectors_per_chunk, f_coord, ring_basis, sum_real, sum_imag);
+		return;
+	}
+
+	int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+	for(int i = 0; i < rings.begin[last_ring] - rings.begin[first_ring]; i++) group_real[i] = group_imag[i] = vfloat();
+	sum_tile_simd<basis_function_id, has_radii, tabulated_radii>(group, tail, vis_config, rings, tile, first_vector, end_vector, vectors_per_chunk, f_coord, ring_basis, group_real, group_imag);
+	for(int ring = first_ring; ring < last_ring; ring++)
+	{
+		vfloat basis = broadcast(basis_function<basis_function_id>(vis_config, broadcast(rings.radius[ring]))[0]);
+		for(int i = rings.begin[ring] - rings.begin[first_ring]; i < rings.begin[ring+1] - rings.begin[first_ring]; i++)
+		{
+			sum_real[i] += basis*group_real[i];
+			sum_imag[i] += basis*group_imag[i];
+		}
+	}
+}
+
+template <BasisFunctionId basis_function_id>
+GroupTileSumSIMD group_tile_sum_simd_level_2(const Group& group)
+{
+	if     (group.d_radii && group.number_of_distinct_radii > 0) return add_group_tile_sum_simd <basis_function_id, true, true>;
+	else if(group.d_radii)                                        return add_group_tile_sum_simd <basis_function_id, true, false>;
+	else                                                          return add_group_tile_sum_simd <basis_function_id, false, false>;
+}
+
+GroupTileSumSIMD group_tile_sum_simd_level_1(const Group& group)
+{
+	if     (group.basis_function_id == GAUSSIAN)       return group_tile_sum_simd_level_2 <GAUSSIAN>       (group);
+	else if(group.basis_function_id == WENDLAND_D3_C2) return group_tile_sum_simd_level_2 <WENDLAND_D3_C2> (group);
+	else                                               return group_tile_sum_simd_level_2 <SPH>            (group);
+}
+
+void sample_fourier_transform_over_grid_fused_simd(const MeshlessDataset& meshless_dataset, VisConfig vis_config, SampleRings rings)
+{
+	int number_of_groups = meshless_dataset.number_of_groups;
+	int vectors_per_chunk = vis_config.tile_terms > simd_width ? vis_config.tile_terms/simd_width : 1;
+
+	// group g's chunks are chunks chunk_begin[g] ... chunk_begin[g+1]-1 of the dataset
+	GroupTail* tails = new GroupTail[number_of_groups];
+	GroupTileSumSIMD* group_tile_sums = new GroupTileSumSIMD[number_of_groups];
+	int* chunk_begin = new int[number_of_groups+1];
+	int padded_most_distinct_radii = 0;
+	chunk_begin[0] = 0;
+	for(int g = 0; g < number_of_groups; g++)
+	{
+		const Group& group = meshless_dataset.groups[g];
+		tails[g] = GroupTail(group);
+		group_tile_sums[g] = group_tile_sum_simd_level_1(group);
+		chunk_begin[g+1] = chunk_begin[g] + (tails[g].number_of_vectors + vectors_per_chunk - 1)/vectors_per_chunk;
+		if(pad_to_simd_width(group.number_of_distinct_radii) > padded_most_distinct_radii) padded_most_distinct_radii = pad_to_simd_width(group.number_of_distinct_radii);
+	}
+	int number_of_chunks = chunk_begin[number_of_groups];
+	int number_of_partitions = number_of_term_partitions(vis_config, rings.number_of_tiles, number_of_chunks);
+
+	int number_of_ring_samples = rings.begin[rings.number_of_rings];
+	float* partial_sums = number_of_partitions > 1 ? (float*)fftwf_malloc(2*sizeof(float)*number_of_partitions*number_of_ring_samples) : 0;
+	WorkStealingTasks tasks(rings.number_of_tiles*number_of_partitions, vis_get_number_of_threads());
+
+	#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+	{
+		VectorBuffer sums(4*rings.largest_tile);
+		vfloat* sum_real = sums.data, *sum_imag = sum_real + rings.largest_tile, *group_real = sum_imag + rings.largest_tile, *group_imag = group_real + rings.largest_tile;
+		float* tile_sums = (float*)fftwf_malloc(2*rings.largest_tile*sizeof(float));
+		float* f_coord = (float*)fftwf_malloc(3*rings.largest_tile*sizeof(float));
+		float* ring_basis = (float*)fftwf_malloc((padded_most_distinct_radii*rings.most_rings_per_tile+1)*sizeof(float));
+
+		int task, current_tile = -1;
+		while(tasks.next(task))
+		{
+			int tile = task/number_of_partitions, partition = task%number_of_partitions;
+			int first_ring = rings.tile_begin[tile], last_ring = rings.tile_begin[tile+1];
+			int number_of_samples = rings.begin[last_ring] - rings.begin[first_ring];
+			if(tile != current_tile)
+			{
+				tile_coordinates_simd(vis_config, rings, tile, f_coord);
+				current_tile = tile;
+			}
+			for(int i = 0; i < number_of_samples; i++) sum_real[i] = sum_imag[i] = vfloat();
+
+			int first_chunk = (int)((long long)number_of_chunks*partition/number_of_partitions);
+			int end_chunk = (int)((long long)number_of_chunks*(partition+1)/number_of_partitions);
+			for(int g = 0; g < number_of_groups; g++)
+			{
+				int first = first_chunk > chunk_begin[g] ? first_chunk : chunk_begin[g], end = end_chunk < chunk_begin[g+1] ? end_chunk : chunk_begin[g+1];
+				if(first >= end) continue;
+				int end_vector = (end - chunk_begin[g])*vectors_per_chunk;
+				if(end_vector > tails[g].number_of_vectors) end_vector = tails[g].number_of_vectors;
+				group_tile_sums[g](node_local_group(meshless_dataset.groups[g]), tails[g], vis_config, rings, tile, (first - chunk_begin[g])*vectors_per_chunk, end_vector,
+					f_coord, ring_basis, group_real, group_imag, sum_real, sum_imag);
+			}
+
+			// the groups' basis functions have been applied, so writing out only scales, as for a single group with radii
+			if(number_of_partitions == 1)
+			{
+				reduce_lanes(number_of_samples, sum_real, sum_imag, tile_sums);
+				write_tile_simd<true, SPH, true>(vis_config, rings, tile, tile_sums);
+			}
+			else reduce_lanes(number_of_samples, sum_real, sum_imag, partial_sums + 2*(partition*number_of_ring_samples + rings.begin[first_ring]));
+		}
+
+		if(number_of_partitions > 1) reduce_partial_sums_simd<true, SPH, true>(vis_config, rings, partial_sums, number_of_partitions, tile_sums);
+
+		fftwf_free(ring_basis);
+		fftwf_free(f_coord);
+		fftwf_free(tile_sums);
+		__builtin_ia32_vzeroupper();	// see sample_fourier_transform_over_grid_simd
+	}
+	fftwf_free(partial_sums);
+	delete[] chunk_begin;
+	delete[] group_tile_sums;
+	delete[] tails;
+}
+
+// see sample_fourier_transform_over_grid_by_recurrence in fourier_transform_cpu.cpp, here each lane holds one sample of the row
+template <bool is_first_group, BasisFunctionId basis_function_id, bool has_radii, bool tabulated_radii>
+void sample_fourier_transform_over_grid_by_recurrence_simd(Group group, VisConfig vis_config)
+{
+	const int reseed_interval = 64;
+	int cutoff_x = vis_config._cutoff_frequency.x;
+	int row_length = 2*cutoff_x;
+	int number_of_vectors = (row_length + simd_width - 1)/simd_width;
+
+	vfloat lane;
+	for(int j = 0; j < simd_width; j++) lane[j] = (float)j;
+
+	// see sample_fourier_transform_over_grid in fourier_transform_cpu.cpp
+	const Group& shared_group = group;
+	#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+	{
+		const Group& group = node_local_group(shared_group);
+		// the samples of a row are stored in order of increasing x, starting at 1-cutoff_x
+		VectorBuffer buffer((3 + (tabulated_radii ? group.number_of_distinct_radii : 0))*number_of_vectors);
+		vfloat* r = buffer.data, *sum_real = r + number_of_vectors, *sum_imag = sum_real + number_of_vectors;
+		vfloat* row_basis = sum_imag + number_of_vectors;	// row_basis[d*number_of_vectors + i]
+
+		#pragma omp for schedule(dynamic,1) nowait
+		for(int y = 0; y < vis_config._cutoff_frequency.y; y++)
+		{
+			float fv = vis_config.step_size.y*y;
+			for(int i = 0; i < number_of_vectors; i++)
+			{
+				vfloat fu = vis_config.step_size.x*(lane + (float)(i*simd_width+1-cutoff_x));
+				for(int j = 0; j < simd_width; j++) r[i][j] = __builtin_sqrtf(fu[j]*fu[j] + fv*fv);
+				sum_real[i] = sum_imag[i] = vfloat();
+			}
+			if(tabulated_radii)
+			{
+				for(int d = 0; d < group.number_of_distinct_radii; d++)
+				{
+					for(int i = 0; i < number_of_vectors; i++) row_basis[d*number_of_vectors + i] = basis_function<basis_function_id>(vis_config, r[i]*group.d_distinct_radii[d]);
+				}
+			}
+
+			// the samples nearest the origin are at distance fv, the terms that are negligible there are negligible for the whole row
+			int number_of_terms = number_of_contributing_terms(group, vis_config._negligible_argument[basis_function_id], fv);
+			for(int k = 0; k < number_of_terms; k++)
+			{
+				float weight = group.d_weights[k];
+				if(weight == 0.0f) continue;	// padding
+
+				// project the term onto the image axes, in turns per sample
+				float u_phase = vis_config.step_size.x*(vis_config.u_axis.x*group.d_x[k] + vis_config.u_axis.y*group.d_y[k] + vis_config.u_axis.z*group.d_z[k]);
+				float v_phase = vis_config.step_size.y*(vis_config.v_axis.x*group.d_x[k] + vis_config.v_axis.y*group.d_y[k] + vis_config.v_axis.z*group.d_z[k]);
+				vfloat term = broadcast(weight);
+
+				for(int first = 0; first < number_of_vectors; first += reseed_interval/simd_width)
+				{
+					vfloat real, imag;
+					sincos_turns((lane + (float)(first*simd_width+1-cutoff_x))*u_phase + y*v_phase, imag, real);
+
+					// the rotation by a whole register of samples is the square of the rotation between lane 0 and the middle lane
+					float half_real = real[simd_width/2]*real[0] + imag[simd_width/2]*imag[0];
+					float half_imag = imag[simd_width/2]*real[0] - real[simd_width/2]*imag[0];
+					vfloat rotation_real = broadcast(half_real*half_real - half_imag*half_imag);
+					vfloat rotation_imag = broadcast(2.0f*half_real*half_imag);
+
+					int last = first + reseed_interval/simd_width;
+					if(last > number_of_vectors) last = number_of_vectors;
+					for(int i = first; i < last; i++)
+					{
+						if     (tabulated_radii) term = weight*row_basis[group.d_radius_indices[k]*number_of_vectors + i];
+						else if(has_radii)       term = weight*basis_function<basis_function_id>(vis_config, r[i]*group.d_radii[k]);
+						sum_real[i] += term*real;
+						sum_imag[i] += term*imag;
+						vfloat rotated_real = real*rotation_real - imag*rotation_imag;
+						imag = real*rotation_imag + imag*rotation_real;
+						real = rotated_real;
+					}
+				}
+			}
+
+			for(int i = 0; i < row_length; i++)
+			{
+				fftwf_complex* sample = sample_destination(vis_config, i+1-cutoff_x, y);
+				if(sample == 0) continue;
+				float real = sum_real[i/simd_width][i%simd_width], imag = sum_imag[i/simd_width][i%simd_width];
+				float scale = vis_config._scale;
+				if(!has_radii) scale *= basis_function<basis_function_id>(vis_config, broadcast(r[i/simd_width][i%simd_width]))[0];	// constant over the terms, so it was factored out
+
+				if(is_first_group)
+				{
+					(*sample)[0]  = real*scale, (*sample)[1]  = -imag*scale;
+				}
+				else
+				{
+					(*sample)[0] += real*scale, (*sample)[1] += -imag*scale;
+				}
+			}
+		}
+	}
+}
+
+template <bool is_first_group, BasisFunctionId basis_function_id>
+void sample_fourier_transform_over_grid_simd_level_2(Group* group, VisConfig* vis_config, const SampleRings* rings)
+{
+	if(vis_config->sampling_method == VIS_PHASE_RECURRENCE)
+	{
+		if     (group->d_radii && group->number_of_distinct_radii > 0) sample_fourier_transform_over_grid_by_recurrence_simd <is_first_group, basis_function_id, true, true>   (*group, *vis_config);
+		else if(group->d_radii)                                         sample_fourier_transform_over_grid_by_recurrence_simd <is_first_group, basis_function_id, true, false>  (*group, *vis_config);
+		else                                                            sample_fourier_transform_over_grid_by_recurrence_simd <is_first_group, basis_function_id, false, false> (*group, *vis_config);
+		return;
+	}
+
+	if     (group->d_radii && group->number_of_distinct_radii > 0) sample_fourier_transform_over_grid_simd <is_first_group, basis_function_id, true, true>   (*group, *vis_config, *rings);
+	else if(group->d_radii)                                         sample_fourier_transform_over_grid_simd <is_first_group, basis_function_id, true, false>  (*group, *vis_config, *rings);
+	else                                                            sample_fourier_transform_over_grid_simd <is_first_group, basis_function_id, false, false> (*group, *vis_config, *rings);
+}
+
+template <bool is_first_group>
+void sample_fourier_transform_over_grid_simd_level_1(Group* group, VisConfig* vis_config, const SampleRings* rings)
+{
+	if     (group->basis_function_id == SPH)            sample_fourier_transform_over_grid_simd_level_2 <is_first_group, SPH>            (group, vis_config, rings);
+	else if(group->basis_function_id == GAUSSIAN)       sample_fourier_transform_over_grid_simd_level_2 <is_first_group, GAUSSIAN>       (group, vis_config, rings);
+	else if(group->basis_function_id == WENDLAND_D3_C2) sample_fourier_transform_over_grid_simd_level_2 <is_first_group, WENDLAND_D3_C2> (group, vis_config, rings);
+}
+
+}
+
+void MESHLESS_VIS_SIMD_ENTRY(Group* group, VisConfig* vis_config, const SampleRings* rings, bool is_first_group)
+{
+	if(is_first_group) sample_fourier_transform_over_grid_simd_level_1 <true>  (group, vis_config, rings);
+	else               sample_fourier_transform_over_grid_simd_level_1 <false> (group, vis_config, rings);
+}
+
+void MESHLESS_VIS_SIMD_FUSED_ENTRY(MeshlessDataset* meshless_dataset, VisConfig* vis_config, const SampleRings* rings)
+{
+	sample_fourier_transform_over_grid_fused_simd(*meshless_dataset, *vis_config, *rings);
+}
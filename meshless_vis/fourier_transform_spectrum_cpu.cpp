@@ -0,0 +1,171 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "fourier_transform_spectrum_cpu.h"
+#include "fourier_transform_nufft_cpu.h"
+#include <cfloat>
+#include <vector>
+
+// The slices are interpolated by convolving the lattice with the same kernel the NUFFT spreads with.  Convolving in frequency
+// multiplies by the kernel's transform in space, so each weight is divided by the kernel's transform at its position beforehand,
+// which makes the interpolation exact up to the aliasing of the kernel.  That aliasing is controlled by making the lattice
+// spacing small enough that the positions only cover the central 1/spectrum_oversampling of the period 1/spacing.
+const int spectrum_oversampling = 2;
+
+// the kernel's transform is tabulated at this many points per unit of t = spacing*position, it varies slowly enough over
+// |t| <= 1/(2 spectrum_oversampling) that linear interpolation is well within single precision
+const int spectrum_table_resolution = 8192;
+
+GroupSpectrum* spectrum_create(Group* group, float radius, float tolerance)
+{
+	int kernel_width = nufft_kernel_width(tolerance);
+	float beta = nufft_kernel_beta(kernel_width);
+
+	float* positions[3] = { group->d_x, group->d_y, group->d_z };
+	float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for(int k = 0; k < group->number_of_terms; k++)
+	{
+		for(int d = 0; d < 3; d++) minimum[d] = std::min(minimum[d], positions[d][k]), maximum[d] = std::max(maximum[d], positions[d][k]);
+	}
+
+	// the lattice is anisotropic, so a flat dataset gets a correspondingly thin lattice
+	float extent[3], largest_extent = 0.0f;
+	for(int d = 0; d < 3; d++) extent[d] = std::max(0.0f, maximum[d] - minimum[d]), largest_extent = std::max(largest_extent, extent[d]);
+	if(largest_extent == 0.0f) largest_extent = 1.0f;
+
+	GroupSpectrum* spectrum = new GroupSpectrum;
+	spectrum->center = make_float3(0.5f*(minimum[0]+maximum[0]), 0.5f*(minimum[1]+maximum[1]), 0.5f*(minimum[2]+maximum[2]));
+	if(group->number_of_terms == 0) spectrum->center = make_float3(0.0f, 0.0f, 0.0f);
+	float spacing[3];
+	for(int d = 0; d < 3; d++)
+	{
+		spacing[d] = 1.0f/(spectrum_oversampling*std::max(extent[d], 1.0e-3f*largest_extent));
+		spectrum->half_number_of_modes[d] = (int)std::ceil(radius/spacing[d] + 0.5f*kernel_width) + 1;
+	}
+	spectrum->spacing = make_float3(spacing[0], spacing[1], spacing[2]);
+	spectrum->radius = radius;
+	spectrum->tolerance = tolerance;
+	spectrum->references = 1;
+
+	std::vector<double> table(spectrum_table_resolution/2 + 2);
+	for(int i = 0; i < (int)table.size(); i++) table[i] = nufft_kernel_transform((double)i/spectrum_table_resolution, kernel_width, beta);
+
+	// the positions in turns per lattice step, and the precompensated weights
+	std::vector<float> u(group->number_of_terms), v(group->number_of_terms), w(group->number_of_terms), weights(group->number_of_terms);
+	float center[3] = { spectrum->center.x, spectrum->center.y, spectrum->center.z };
+
+	#pragma omp parallel for default(shared) schedule(static) num_threads(vis_get_number_of_threads())
+	for(int k = 0; k < group->number_of_terms; k++)
+	{
+		float* turns[3] = { &u[k], &v[k], &w[k] };
+		double transform = 1.0;
+		for(int d = 0; d < 3; d++)
+		{
+			*turns[d] = spacing[d]*(positions[d][k] - center[d]);
+			double t = std::fabs(*turns[d])*spectrum_table_resolution;
+			int i = std::min((int)t, (int)table.size()-2);
+			transform *= table[i] + (t - i)*(table[i+1] - table[i]);
+		}
+		weights[k] = (float)(group->d_weights[k]/transform);
+	}
+
+	int number_of_modes = (2*spectrum->half_number_of_modes[0]+1)*(2*spectrum->half_number_of_modes[1]+1)*(spectrum->half_number_of_modes[2]+1);
+	spectrum->modes = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*number_of_modes);
+	nufft_type_1_3d(group->number_of_terms, &u[0], &v[0], &w[0], &weights[0], spectrum->half_number_of_modes, tolerance, spectrum->modes);
+
+	return spectrum;
+}
+
+void spectrum_destroy(GroupSpectrum* spectrum)
+{
+	if(spectrum == 0) return;
+	fftwf_free(spectrum->modes);
+	delete spectrum;
+}
+
+void spectrum_release(GroupSpectrum* spectrum)
+{
+	if(spectrum == 0) return;
+	bool is_last;
+	#pragma omp critical(group_spectrum)
+	is_last = --spectrum->references == 0;
+	if(is_last) spectrum_destroy(spectrum);
+}
+
+size_t spectrum_size(const GroupSpectrum* spectrum)
+{
+	if(spectrum == 0) return 0;
+	const int* half = spectrum->half_number_of_modes;
+	return sizeof(GroupSpectrum) + sizeof(fftwf_complex)*(size_t)(2*half[0]+1)*(2*half[1]+1)*(half[2]+1);
+}
+
+void spectrum_slice(GroupSpectrum* spectrum, VisConfig* vis_config, fftwf_complex* sums)
+{
+	int kernel_width = nufft_kernel_width(spectrum->tolerance);
+	float beta = nufft_kernel_beta(kernel_width);
+	int cutoff_x = vis_config->_cutoff_frequency.x;
+	int row_length = 2*cutoff_x;
+	const int* half = spectrum->half_number_of_modes;
+	int number_of_modes_y = 2*half[1]+1, number_of_modes_z = half[2]+1;
+
+	#pragma omp parallel for default(shared) schedule(dynamic,1) num_threads(vis_get_number_of_threads())
+	for(int y = 0; y < vis_config->_cutoff_frequency.y; y++)
+	{
+		float kernel[3][nufft_max_kernel_width];
+		int first[3];
+
+		for(int i = 0; i < row_length; i++)
+		{
+			float fu = vis_config->step_size.x*(i+1-cutoff_x), fv = vis_config->step_size.y*y;
+			float3 f = make_float3(fu*vis_config->u_axis.x + fv*vis_config->v_axis.x, fu*vis_config->u_axis.y + fv*vis_config->v_axis.y, fu*vis_config->u_axis.z + fv*vis_config->v_axis.z);
+			nufft_evaluate_kernel(f.x/spectrum->spacing.x, kernel_width, beta, first[0], kernel[0]);
+			nufft_evaluate_kernel(f.y/spectrum->spacing.y, kernel_width, beta, first[1], kernel[1]);
+			nufft_evaluate_kernel(f.z/spectrum->spacing.z, kernel_width, beta, first[2], kernel[2]);
+
+			float real = 0.0f, imag = 0.0f;
+			for(int a = 0; a < kernel_width; a++)
+			{
+				for(int b = 0; b < kernel_width; b++)
+				{
+					float kernel_xy = kernel[0][a]*kernel[1][b];
+					int mx = first[0]+a, my = first[1]+b;
+					for(int c = 0; c < kernel_width; c++)
+					{
+						// only z >= 0 is stored, the rest is the complex conjugate of the mirrored mode
+						int mz = first[2]+c;
+						float sign = 1.0f;
+						const fftwf_complex* mode;
+						if(mz >= 0) mode = spectrum->modes + ((long)(mx + half[0])*number_of_modes_y + my + half[1])*number_of_modes_z + mz;
+						else        mode = spectrum->modes + ((long)(half[0] - mx)*number_of_modes_y + half[1] - my)*number_of_modes_z - mz, sign = -1.0f;
+						real += kernel_xy*kernel[2][c]*(*mode)[0];
+						imag += kernel_xy*kernel[2][c]*(*mode)[1]*sign;
+					}
+				}
+			}
+
+			// shift back from the center of the bounding box
+			double phase = 6.283185307179586476925286766559*((double)f.x*spectrum->center.x + (double)f.y*spectrum->center.y + (double)f.z*spectrum->center.z);
+			float shift_real = (float)std::cos(phase), shift_imag = (float)std::sin(phase);
+			sums[y*row_length+i][0] = real*shift_real - imag*shift_imag;
+			sums[y*row_length+i][1] = real*shift_imag + imag*shift_real;
+		}
+	}
+}
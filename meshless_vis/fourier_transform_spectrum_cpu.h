@@ -0,0 +1,50 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FOURIER_TRANSFORM_SPECTRUM_CPU_H_
+#define FOURIER_TRANSFORM_SPECTRUM_CPU_H_
+
+#include "meshless_vis.h"
+#include "meshless.h"
+
+// The 3D spectrum sum_k weight_k exp(2 pi i f.p_k) of a group, sampled on a lattice of frequencies, from which the spectrum at any
+// frequency within radius can be interpolated.  The slices of it taken by VIS_SPECTRUM_SLICE cost the same for any number of terms.
+struct GroupSpectrum
+{
+	float3 center;					// the positions are taken relative to the center of their bounding box
+	float3 spacing;					// the distance between neighbouring frequencies of the lattice
+	int half_number_of_modes[3];	// see nufft_type_1_3d for the layout of modes
+	float radius;
+	float tolerance;
+	fftwf_complex* modes;
+	int references;					// held by the group and every render slicing it, counted in the critical section group_spectrum
+};
+
+// creates a spectrum with one reference, for the group
+GroupSpectrum* spectrum_create(Group* group, float radius, float tolerance);
+void spectrum_destroy(GroupSpectrum* spectrum);
+void spectrum_release(GroupSpectrum* spectrum);	// destroys the spectrum with its last reference
+size_t spectrum_size(const GroupSpectrum* spectrum);	// in bytes
+
+// interpolates the slice of the spectrum sampled by vis_config, sums is stored like the output of nufft_type_1 with first_mode_u = 1-cutoff_x
+void spectrum_slice(GroupSpectrum* spectrum, VisConfig* vis_config, fftwf_complex* sums);
+
+#endif /*FOURIER_TRANSFORM_SPECTRUM_CPU_H_*/
@@ -0,0 +1,55 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FOURIER_TRANSFORM_TABLES_CPU_H_
+#define FOURIER_TRANSFORM_TABLES_CPU_H_
+
+#include "meshless_vis.h"
+#include "meshless.h"
+
+// A basis function's Fourier transform interpolated from a table of cubics, one per interval of 1/intervals_per_unit, in place of
+// the analytic form whenever vis_config->basis_function_tolerance is not zero.  The table covers [0, range], where range is the
+// farthest any kernel will look for the current step size, cutoff frequency and registered radii (see update_basis_function_tables).
+// It is kept free of the standard library so the vectorized kernels can use it too.
+struct BasisFunctionTable
+{
+	float range;
+	float intervals_per_unit;
+	int number_of_intervals;
+	float tolerance;			// what the table was built for
+	float error;				// the largest error measured against the analytic form, relative to max(|transform(r)|, |transform(0)|)
+	float* coefficients[4];		// on interval i the transform is coefficients[0][i] + t*(coefficients[1][i] + t*(...)), 0 <= t <= 1
+};
+
+inline float basis_function_table_lookup(const BasisFunctionTable* table, float r)
+{
+	float t = r*table->intervals_per_unit;
+	int i = (int)t;
+	i = i < 0 ? 0 : (i < table->number_of_intervals ? i : table->number_of_intervals-1);	// past the end the last cubic is extrapolated
+	t -= (float)i;
+	return table->coefficients[0][i] + t*(table->coefficients[1][i] + t*(table->coefficients[2][i] + t*table->coefficients[3][i]));
+}
+
+// (re)builds the tables of vis_config when they don't reach far enough for meshless_dataset (which may be 0) or the tolerance changed
+void update_basis_function_tables(VisConfig* vis_config, MeshlessDataset* meshless_dataset);
+void destroy_basis_function_tables(VisConfig* vis_config);
+
+#endif /*FOURIER_TRANSFORM_TABLES_CPU_H_*/
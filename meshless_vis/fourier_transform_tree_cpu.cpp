@@ -0,0 +1,283 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "fourier_transform_tree_cpu.h"
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+// the Taylor series are truncated after the terms of this degree, which leaves (order+1)(order+2)(order+3)/6 moments per node,
+// and the truncation error of a node of radius rho at frequency f is at most (2 pi |f| rho)^(order+1)/(order+1)! per unit weight
+const int tree_expansion_order = 6;
+const int tree_number_of_moments = (tree_expansion_order+1)*(tree_expansion_order+2)*(tree_expansion_order+3)/6;
+const int tree_leaf_size = 32;
+const int tree_max_depth = 20;
+
+// the exponents (a, b, c) of every moment.  i^(a+b+c) makes the moments of even degree contribute to the real part and those of
+// odd degree to the imaginary part, so the even ones are stored first, number_of_even of them
+struct TreeExponents
+{
+	int a[tree_number_of_moments], b[tree_number_of_moments], c[tree_number_of_moments];
+	float inverse_factorial[tree_number_of_moments];	// 1/(a! b! c!)
+	int number_of_even;
+
+	TreeExponents()
+	{
+		int m = 0;
+		for(int parity = 0; parity < 2; parity++) for(int degree = parity; degree <= tree_expansion_order; degree += 2)
+		{
+			if(parity == 1 && degree == 1) number_of_even = m;
+			for(int i = degree; i >= 0; i--) for(int j = degree-i; j >= 0; j--)
+			{
+				a[m] = i, b[m] = j, c[m] = degree-i-j;
+				double factorial = 1.0;
+				for(int k = 2; k <= i; k++) factorial *= k;
+				for(int k = 2; k <= j; k++) factorial *= k;
+				for(int k = 2; k <= degree-i-j; k++) factorial *= k;
+				inverse_factorial[m++] = (float)(1.0/factorial);
+			}
+		}
+	}
+};
+
+GroupTree* tree_create(Group* group)
+{
+	int n = group->number_of_terms;
+	GroupTree* tree = new GroupTree;
+	float** arrays[4] = { &tree->x, &tree->y, &tree->z, &tree->weights };
+	float* group_arrays[4] = { group->d_x, group->d_y, group->d_z, group->d_weights };
+	for(int i = 0; i < 4; i++)
+	{
+		*arrays[i] = (float*)fftwf_malloc(sizeof(float)*std::max(n, 1));
+		std::copy(group_arrays[i], group_arrays[i] + n, *arrays[i]);
+	}
+
+	// the nodes are split breadth first, each node's children are appended together so they are consecutive
+	std::vector<TreeNode> nodes(1);
+	std::vector<int> depth(1, 0);
+	nodes[0].first_term = 0, nodes[0].last_term = n;
+	std::vector<float> scratch(4*std::max(n, 1));
+	for(int i = 0; i < (int)nodes.size(); i++)
+	{
+		int first = nodes[i].first_term, last = nodes[i].last_term;
+		float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for(int k = first; k < last; k++)
+		{
+			float p[3] = { tree->x[k], tree->y[k], tree->z[k] };
+			for(int d = 0; d < 3; d++) minimum[d] = std::min(minimum[d], p[d]), maximum[d] = std::max(maximum[d], p[d]);
+		}
+		float center[3] = { 0.0f, 0.0f, 0.0f };
+		if(last > first) for(int d = 0; d < 3; d++) center[d] = 0.5f*(minimum[d] + maximum[d]);
+
+		float radius_squared = 0.0f;
+		for(int k = first; k < last; k++)
+		{
+			float dx = tree->x[k]-center[0], dy = tree->y[k]-center[1], dz = tree->z[k]-center[2];
+			radius_squared = std::max(radius_squared, dx*dx + dy*dy + dz*dz);
+		}
+		nodes[i].center = make_float3(center[0], center[1], center[2]);
+		nodes[i].radius = sqrtf(radius_squared);
+		nodes[i].first_child = 0, nodes[i].number_of_children = 0;
+		if(last - first <= tree_leaf_size || depth[i] >= tree_max_depth) continue;
+
+		// sort the terms into octants around the center
+		int count[8] = { 0 }, offset[8];
+		std::vector<unsigned char> octant(last - first);
+		for(int k = first; k < last; k++)
+		{
+			octant[k-first] = (unsigned char)((tree->x[k] > center[0]) | ((tree->y[k] > center[1]) << 1) | ((tree->z[k] > center[2]) << 2));
+			count[octant[k-first]]++;
+		}
+		offset[0] = 0;
+		for(int o = 1; o < 8; o++) offset[o] = offset[o-1] + count[o-1];
+		for(int k = first; k < last; k++)
+		{
+			int j = offset[octant[k-first]]++;
+			for(int a = 0; a < 4; a++) scratch[4*j+a] = (*arrays[a])[k];
+		}
+		for(int j = 0; j < last - first; j++) for(int a = 0; a < 4; a++) (*arrays[a])[first+j] = scratch[4*j+a];
+
+		int first_child = (int)nodes.size(), start = first;
+		for(int o = 0; o < 8; o++)
+		{
+			if(count[o] == 0) continue;
+			TreeNode child;
+			child.first_term = start, child.last_term = start + count[o];
+			start += count[o];
+			nodes.push_back(child);
+			depth.push_back(depth[i] + 1);
+		}
+		nodes[i].first_child = first_child;
+		nodes[i].number_of_children = (int)nodes.size() - first_child;
+	}
+
+	tree->number_of_nodes = (int)nodes.size();
+	tree->nodes = new TreeNode[nodes.size()];
+	std::copy(nodes.begin(), nodes.end(), tree->nodes);
+
+	// the moments of every node, straight from its terms
+	TreeExponents exponents;
+	tree->moments = (float*)fftwf_malloc(sizeof(float)*tree_number_of_moments*tree->number_of_nodes);
+
+	#pragma omp parallel for default(shared) schedule(dynamic,16) num_threads(vis_get_number_of_threads())
+	for(int i = 0; i < tree->number_of_nodes; i++)
+	{
+		const TreeNode& node = tree->nodes[i];
+		double moments[tree_number_of_moments] = { 0.0 };
+		for(int k = node.first_term; k < node.last_term; k++)
+		{
+			float power[3][tree_expansion_order+1];
+			float p[3] = { tree->x[k]-node.center.x, tree->y[k]-node.center.y, tree->z[k]-node.center.z };
+			for(int d = 0; d < 3; d++)
+			{
+				power[d][0] = 1.0f;
+				for(int e = 1; e <= tree_expansion_order; e++) power[d][e] = power[d][e-1]*p[d];
+			}
+			for(int m = 0; m < tree_number_of_moments; m++) moments[m] += tree->weights[k]*power[0][exponents.a[m]]*power[1][exponents.b[m]]*power[2][exponents.c[m]];
+		}
+		for(int m = 0; m < tree_number_of_moments; m++) tree->moments[i*tree_number_of_moments + m] = (float)(moments[m]*exponents.inverse_factorial[m]);
+	}
+
+	return tree;
+}
+
+void tree_destroy(GroupTree* tree)
+{
+	if(tree == 0) return;
+	fftwf_free(tree->x), fftwf_free(tree->y), fftwf_free(tree->z), fftwf_free(tree->weights);
+	fftwf_free(tree->moments);
+	delete [] tree->nodes;
+	delete tree;
+}
+
+size_t tree_size(const GroupTree* tree)
+{
+	if(tree == 0) return 0;
+	size_t number_of_terms = tree->nodes[0].last_term - tree->nodes[0].first_term;
+	return sizeof(GroupTree) + (sizeof(TreeNode) + sizeof(float)*tree_number_of_moments)*tree->number_of_nodes + 4*sizeof(float)*number_of_terms;
+}
+
+void tree_sum(GroupTree* tree, VisConfig* vis_config, const SampleRings* rings, float tolerance, fftwf_complex* sums)
+{
+	const float _2_pi = 6.283185307179586476925286766559f;
+	int cutoff_x = vis_config->_cutoff_frequency.x;
+	int row_length = 2*cutoff_x;
+
+	// a node is summed from its moments when 2 pi |f| rho is at most largest_phase
+	double factorial = 1.0;
+	for(int k = 2; k <= tree_expansion_order+1; k++) factorial *= k;
+	float largest_phase = (float)std::pow(tolerance*factorial, 1.0/(tree_expansion_order+1));
+
+	TreeExponents exponents;
+
+	#pragma omp parallel default(shared) num_threads(vis_get_number_of_threads())
+	{
+		std::vector<int> expanded, summed, stack;
+		std::vector<float3> f_coord;
+		float monomials[tree_number_of_moments];
+
+		#pragma omp for schedule(dynamic,1) nowait
+		for(int ring = 0; ring < rings->number_of_rings; ring++)
+		{
+			const int* samples = rings->samples + rings->begin[ring];
+			int number_of_samples = rings->begin[ring+1] - rings->begin[ring];
+
+			// the samples of a ring are all about the same distance from the origin, so they share the choice of nodes
+			f_coord.resize(number_of_samples);
+			float largest_frequency = 0.0f;
+			for(int i = 0; i < number_of_samples; i++)
+			{
+				int x = samples[i] % row_length;
+				if(x > cutoff_x) x = x - row_length;
+				int y = samples[i] / row_length;
+				float fu = vis_config->step_size.x*x, fv = vis_config->step_size.y*y;
+				f_coord[i] = make_float3(fu*vis_config->u_axis.x + fv*vis_config->v_axis.x, fu*vis_config->u_axis.y + fv*vis_config->v_axis.y, fu*vis_config->u_axis.z + fv*vis_config->v_axis.z);
+				largest_frequency = std::max(largest_frequency, sqrtf(f_coord[i].x*f_coord[i].x + f_coord[i].y*f_coord[i].y + f_coord[i].z*f_coord[i].z));
+			}
+
+			expanded.clear(), summed.clear(), stack.assign(1, 0);
+			while(!stack.empty())
+			{
+				int i = stack.back();
+				stack.pop_back();
+				const TreeNode& node = tree->nodes[i];
+				if(node.last_term == node.first_term) continue;
+				if(_2_pi*largest_frequency*node.radius <= largest_phase) expanded.push_back(i);
+				else if(node.number_of_children == 0)                    summed.push_back(i);
+				else for(int child = 0; child < node.number_of_children; child++) stack.push_back(node.first_child + child);
+			}
+
+			for(int i = 0; i < number_of_samples; i++)
+			{
+				float3 f = f_coord[i];
+				double sum_real = 0.0, sum_imag = 0.0;
+
+				if(!expanded.empty())
+				{
+					// (2 pi i f)^a/a! etc., the 1/a! is already in the moments
+					float power[3][tree_expansion_order+1];
+					float g[3] = { _2_pi*f.x, _2_pi*f.y, _2_pi*f.z };
+					for(int d = 0; d < 3; d++)
+					{
+						power[d][0] = 1.0f;
+						for(int e = 1; e <= tree_expansion_order; e++) power[d][e] = power[d][e-1]*g[d];
+					}
+					for(int m = 0; m < tree_number_of_moments; m++)
+					{
+						int degree = exponents.a[m] + exponents.b[m] + exponents.c[m];
+						monomials[m] = power[0][exponents.a[m]]*power[1][exponents.b[m]]*power[2][exponents.c[m]];
+						if((degree & 2) != 0) monomials[m] = -monomials[m];		// the sign of i^degree
+					}
+				}
+				for(size_t e = 0; e < expanded.size(); e++)
+				{
+					const TreeNode& node = tree->nodes[expanded[e]];
+					const float* moments = tree->moments + expanded[e]*tree_number_of_moments;
+					float real = 0.0f, imag = 0.0f;
+					for(int m = 0; m < exponents.number_of_even; m++)                      real += moments[m]*monomials[m];
+					for(int m = exponents.number_of_even; m < tree_number_of_moments; m++) imag += moments[m]*monomials[m];
+
+					float v = _2_pi*(f.x*node.center.x + f.y*node.center.y + f.z*node.center.z);
+					float cos_v = std::cos(v), sin_v = std::sin(v);
+					sum_real += cos_v*real - sin_v*imag;
+					sum_imag += cos_v*imag + sin_v*real;
+				}
+				for(size_t s = 0; s < summed.size(); s++)
+				{
+					const TreeNode& node = tree->nodes[summed[s]];
+					for(int k = node.first_term; k < node.last_term; k++)
+					{
+						float v = _2_pi*(f.x*tree->x[k] + f.y*tree->y[k] + f.z*tree->z[k]);
+						sum_real += tree->weights[k]*std::cos(v);
+						sum_imag += tree->weights[k]*std::sin(v);
+					}
+				}
+
+				int x = samples[i] % row_length;
+				if(x > cutoff_x) x = x - row_length;
+				int y = samples[i] / row_length;
+				sums[y*row_length + x + cutoff_x - 1][0] = (float)sum_real;
+				sums[y*row_length + x + cutoff_x - 1][1] = (float)sum_imag;
+			}
+		}
+	}
+}
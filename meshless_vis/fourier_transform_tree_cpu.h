@@ -0,0 +1,59 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef FOURIER_TRANSFORM_TREE_CPU_H_
+#define FOURIER_TRANSFORM_TREE_CPU_H_
+
+#include "meshless_vis.h"
+#include "meshless.h"
+#include "fourier_transform_rings_cpu.h"
+
+// An octree over a group's terms for VIS_HIERARCHICAL.  Within a node of radius rho around center c the phase of every term at
+// frequency f is exp(2 pi i f.c) exp(2 pi i f.(p-c)), and while 2 pi |f| rho is small the second factor is well approximated by
+// its Taylor series, so the node's terms can be summed from the moments sum_k weight_k (p_k-c)^a/a! of the node, whatever their
+// number.  Low frequencies are summed from a few large nodes, high frequencies descend further and sum the terms of the leaves.
+struct TreeNode
+{
+	float3 center;
+	float radius;			// of the sphere around center holding all of the node's terms
+	int first_term;			// the node holds terms first_term ... last_term-1 of the tree's arrays
+	int last_term;
+	int first_child;		// the children are nodes first_child ... first_child+number_of_children-1
+	int number_of_children;
+};
+
+struct GroupTree
+{
+	int number_of_nodes;
+	TreeNode* nodes;
+	float* moments;			// tree_number_of_moments per node
+	float* x, *y, *z, *weights;	// the group's terms, reordered so every node's terms are consecutive
+};
+
+GroupTree* tree_create(Group* group);
+void tree_destroy(GroupTree* tree);
+size_t tree_size(const GroupTree* tree);	// in bytes
+
+// sums weight_k exp(2 pi i f.p_k) over the group at every sample of vis_config to within tolerance times the sum of the absolute
+// values of the weights, sums is stored like the output of nufft_type_1 with first_mode_u = 1-cutoff_x
+void tree_sum(GroupTree* tree, VisConfig* vis_config, const SampleRings* rings, float tolerance, fftwf_complex* sums);
+
+#endif /*FOURIER_TRANSFORM_TREE_CPU_H_*/
@@ -0,0 +1,210 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "memory_cpu.h"
+
+#include <fftw3.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#endif
+
+// arrays smaller than a huge page aren't worth one
+const size_t huge_page_size = 2*1024*1024;
+
+enum AllocationKind { TRANSPARENT_HUGE_PAGES, EXPLICIT_HUGE_PAGES };
+struct Allocation
+{
+	AllocationKind kind;
+	size_t size;
+};
+
+// the allocations that didn't come from fftwf_malloc
+static std::map<void*, Allocation> allocations;
+
+void* memory_allocate(size_t size, VisHugePages huge_pages)
+{
+#ifdef __linux__
+	if(huge_pages != VIS_HUGE_PAGES_NONE && size >= huge_page_size)
+	{
+		Allocation allocation;
+		allocation.size = huge_page_size*((size + huge_page_size - 1)/huge_page_size);
+		void* memory = 0;
+		if(huge_pages == VIS_HUGE_PAGES_EXPLICIT)
+		{
+			// from the pool reserved in /proc/sys/vm/nr_hugepages, falling back on transparent huge pages if it's too small
+			memory = mmap(0, allocation.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if(memory == MAP_FAILED) memory = 0;
+			allocation.kind = EXPLICIT_HUGE_PAGES;
+		}
+		if(memory == 0)
+		{
+			if(posix_memalign(&memory, huge_page_size, allocation.size) != 0) return 0;
+			madvise(memory, allocation.size, MADV_HUGEPAGE);
+			allocation.kind = TRANSPARENT_HUGE_PAGES;
+		}
+		#pragma omp critical(memory_allocations)
+		allocations[memory] = allocation;
+		return memory;
+	}
+#endif
+	return fftwf_malloc(size);
+}
+
+void memory_free(void* memory)
+{
+	if(memory == 0) return;
+
+	bool found = false;
+	Allocation allocation;
+	#pragma omp critical(memory_allocations)
+	{
+		std::map<void*, Allocation>::iterator i = allocations.find(memory);
+		if(i != allocations.end()) found = true, allocation = i->second, allocations.erase(i);
+	}
+	if(!found) { fftwf_free(memory); return; }
+#ifdef __linux__
+	if(allocation.kind == EXPLICIT_HUGE_PAGES) munmap(memory, allocation.size);
+	else                                       free(memory);
+#endif
+}
+
+int memory_current_node()
+{
+#if defined(WIN32)
+	UCHAR node = 0;
+	if(!GetNumaProcessorNode((UCHAR)GetCurrentProcessorNumber(), &node)) return 0;
+	return node;
+#elif defined(__linux__) && defined(SYS_getcpu)
+	unsigned int cpu = 0, node = 0;
+	if(syscall(SYS_getcpu, &cpu, &node, 0) != 0) return 0;
+	return (int)node;
+#else
+	return 0;
+#endif
+}
+
+int memory_number_of_nodes()
+{
+	// found once, concurrent first calls may both look
+	static int number_of_nodes = 0;
+	int found;
+	#pragma omp critical(memory_number_of_nodes)
+	found = number_of_nodes;
+	if(found > 0) return found;
+
+	int nodes = 1;
+#if defined(WIN32)
+	ULONG highest_node = 0;
+	if(GetNumaHighestNodeNumber(&highest_node)) nodes = (int)highest_node + 1;
+#elif defined(__linux__)
+	DIR* directory = opendir("/sys/devices/system/node");
+	if(directory)
+	{
+		int highest_node = 0;
+		for(dirent* entry = readdir(directory); entry != 0; entry = readdir(directory))
+		{
+			if(strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') highest_node = std::max(highest_node, atoi(entry->d_name + 4));
+		}
+		closedir(directory);
+		nodes = highest_node + 1;
+	}
+#endif
+	#pragma omp critical(memory_number_of_nodes)
+	number_of_nodes = nodes;
+	return nodes;
+}
+
+const Group& node_local_group(const Group& group)
+{
+	if(group.d_replicas == 0) return group;
+	int node = memory_current_node();
+	return node < group.d_replicas->number_of_nodes ? group.d_replicas->groups[node] : group;
+}
+
+template <typename T>
+static T* replicate(const T* array, int length, VisHugePages huge_pages)
+{
+	if(array == 0) return 0;
+	T* copy = (T*)memory_allocate(sizeof(T)*length, huge_pages);
+	memcpy(copy, array, sizeof(T)*length);
+	return copy;
+}
+
+GroupReplicas* replicas_create(const Group& group, VisHugePages huge_pages)
+{
+	int number_of_nodes = memory_number_of_nodes();
+	if(number_of_nodes < 2) return 0;
+
+	GroupReplicas* replicas = new GroupReplicas;
+	replicas->number_of_nodes = number_of_nodes;
+	replicas->groups = new Group[number_of_nodes];
+	replicas->is_replicated = new bool[number_of_nodes];
+	for(int node = 0; node < number_of_nodes; node++) replicas->groups[node] = group, replicas->is_replicated[node] = false;
+
+	// the first of the pool's threads to find itself on a node copies the arrays there
+	#pragma omp parallel num_threads(vis_get_number_of_threads())
+	{
+		int node = memory_current_node();
+		bool is_first = false;
+		#pragma omp critical(memory_replicas)
+		if(node < number_of_nodes && !replicas->is_replicated[node]) is_first = replicas->is_replicated[node] = true;
+
+		if(is_first)
+		{
+			Group& copy = replicas->groups[node];
+			copy.d_x = replicate(group.d_x, group.d_number_of_terms, huge_pages);
+			copy.d_y = replicate(group.d_y, group.d_number_of_terms, huge_pages);
+			copy.d_z = replicate(group.d_z, group.d_number_of_terms, huge_pages);
+			copy.d_weights = replicate(group.d_weights, group.d_number_of_terms, huge_pages);
+			copy.d_radii = replicate(group.d_radii, group.d_number_of_terms, huge_pages);
+			copy.d_radius_indices = replicate(group.d_radius_indices, group.d_number_of_terms, huge_pages);
+			copy.d_replicas = 0;
+		}
+	}
+	return replicas;
+}
+
+void replicas_destroy(GroupReplicas* replicas)
+{
+	if(replicas == 0) return;
+	for(int node = 0; node < replicas->number_of_nodes; node++)
+	{
+		if(!replicas->is_replicated[node]) continue;
+		Group& copy = replicas->groups[node];
+		memory_free(copy.d_x), memory_free(copy.d_y), memory_free(copy.d_z), memory_free(copy.d_weights);
+		memory_free(copy.d_radii), memory_free(copy.d_radius_indices);
+	}
+	delete[] replicas->groups;
+	delete[] replicas->is_replicated;
+	delete replicas;
+}
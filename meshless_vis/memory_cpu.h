@@ -0,0 +1,54 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef MEMORY_CPU_H_
+#define MEMORY_CPU_H_
+
+#include "meshless_vis.h"
+#include "meshless.h"
+#include <cstddef>
+
+// Allocates memory for the registered terms and the sample and image buffers, backed by huge pages if asked for and the array is
+// large enough, otherwise from fftwf_malloc.  Free it with memory_free, which also takes memory from fftwf_malloc.
+void* memory_allocate(size_t size, VisHugePages huge_pages);
+void memory_free(void* memory);
+
+// the NUMA node the calling thread is running on, and how many nodes there are, 0 and 1 where that can't be found out
+int memory_current_node();
+int memory_number_of_nodes();
+
+// A copy of a group per NUMA node, whose arrays were copied by (and so first touched from) one of the pool's threads running on
+// that node.  Nodes that none of the threads ran on share the group's own arrays.
+struct GroupReplicas
+{
+	int number_of_nodes;
+	Group* groups;				// groups[node]
+	bool* is_replicated;		// whether groups[node] has arrays of its own
+};
+
+GroupReplicas* replicas_create(const Group& group, VisHugePages huge_pages);
+void replicas_destroy(GroupReplicas* replicas);
+
+// the copy of the group on the calling thread's node, or the group itself.  Not inline, so that the copy the vectorized kernels
+// would compile can't end up in the scalar code (see fourier_transform_simd_cpu.inl).
+const Group& node_local_group(const Group& group);
+
+#endif /*MEMORY_CPU_H_*/
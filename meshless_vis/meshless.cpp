@@ -1,189 +1,1518 @@
-/*
-libMeshlessVis
-Copyright (C) 2008 Andrew Corrigan
-
-This program is free software; you can redistribute it and/or
-modify it under the terms of the GNU General Public License
-as published by the Free Software Foundation; either version 2
-of the License, or (at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program; if not, write to the Free Software
-Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
-*/
-
-#include "meshless.h"
-#include <vector>
-#include <string>
-#include <cstring>
-#include <iostream>
-#include <fstream>
-
-MeshlessDataset get_simple_meshless_dataset(int number_of_terms, Constraint* h_constraints, float* h_radii, BasisFunctionId basis_function_id)
-{
-	MeshlessDataset meshless_dataset;
-	meshless_dataset.number_of_groups = 1;
-	meshless_dataset.groups = new Group[1];
-	meshless_dataset.groups[0].basis_function_id = basis_function_id;
-	meshless_dataset.groups[0].number_of_terms = number_of_terms;
-	meshless_dataset.groups[0].h_constraints = h_constraints;
-	meshless_dataset.groups[0].h_radii = h_radii;
-	return meshless_dataset;
-}
-
-void delete_meshless_dataset(MeshlessDataset meshless_dataset)
-{
-	for(int i = 0; i != meshless_dataset.number_of_groups; i++)
-	{
-		delete[] meshless_dataset.groups[i].h_constraints;
-		if(meshless_dataset.groups[i].h_radii != 0) delete[] meshless_dataset.groups[i].h_radii;
-	}
-	delete[] meshless_dataset.groups;
-}
-
-void delete_meshless_datasets(MeshlessDataset* meshless_datasets, int number_of_datasets)
-{
-	for(int i = 0; i != number_of_datasets; i++)
-	{
-		delete_meshless_dataset(meshless_datasets[i]);
-	}
-	delete[] meshless_datasets;
-}
-
-int get_number_of_terms(MeshlessDataset* meshless_dataset)
-{
-	int N = 0;
-	for(int i = 0; i != meshless_dataset->number_of_groups; i++)
-	{
-		N += meshless_dataset->groups[i].number_of_terms;
-	}
-	return N;
-}
-
-void shift_meshless_dataset(MeshlessDataset* meshless_dataset, float x, float y, float z)
-{
-	for(int j = 0; j != meshless_dataset->number_of_groups; j++)
-	{
-		for(int k = 0; k != meshless_dataset->groups[j].number_of_terms; k++)
-		{
-			meshless_dataset->groups[j].h_constraints[k].position.x += x;
-			meshless_dataset->groups[j].h_constraints[k].position.y += y;
-			meshless_dataset->groups[j].h_constraints[k].position.z += z;
-		}
-	}
-}
-
-void shift_meshless_datasets(MeshlessDataset* meshless_datasets, int number_of_datasets, float x, float y, float z)
-{
-	for(int i = 0; i != number_of_datasets; ++i) shift_meshless_dataset(meshless_datasets+i, x,y,z);
-}
-
-void load_meshless_datasets_from_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets)
-{
-	std::ifstream file(filename);
-
-	file >> *number_of_datasets;
-	if(*number_of_datasets == 0)
-	{
-		(*meshless_datasets) = 0;
-		return;	
-	}
-
-	(*meshless_datasets) = new MeshlessDataset[*number_of_datasets];
-
-	for(int i = 0; i != *number_of_datasets; i++) {
-		
-		file >> (*meshless_datasets)[i].number_of_groups;
-		(*meshless_datasets)[i].groups = new Group[(*meshless_datasets)[i].number_of_groups];
-		for(int j = 0; j != (*meshless_datasets)[i].number_of_groups; j++) {
-			std::string basis_function_name, ignore_operator;
-			file >> (*meshless_datasets)[i].groups[j].number_of_terms;
-
-			file >> basis_function_name;
-			if(basis_function_name == "sph")                 (*meshless_datasets)[i].groups[j].basis_function_id = SPH;
-			else if(basis_function_name == "gaussian")       (*meshless_datasets)[i].groups[j].basis_function_id = GAUSSIAN;
-			else if(basis_function_name == "wendland_d3_c2") (*meshless_datasets)[i].groups[j].basis_function_id = WENDLAND_D3_C2;
-
-			file >>  ignore_operator;
-	
-			//todo: handle parameters
-			int parameters;
-			file >> parameters;		//0 if none, 1 if each bf has a parameter, 2 if all are the same
-		}
-		for(int j = 0; j != (*meshless_datasets)[i].number_of_groups; j++)
-		{
-			(*meshless_datasets)[i].groups[j].h_constraints = new Constraint[(*meshless_datasets)[i].groups[j].number_of_terms];
-
-			for(int k = 0; k != (*meshless_datasets)[i].groups[j].number_of_terms; k++) 
-				file >> (*meshless_datasets)[i].groups[j].h_constraints[k].position.x >> (*meshless_datasets)[i].groups[j].h_constraints[k].position.y >> (*meshless_datasets)[i].groups[j].h_constraints[k].position.z;
-		}
-
-		for(int j = 0; j != (*meshless_datasets)[i].number_of_groups; j++)
-			for(int k = 0; k != (*meshless_datasets)[i].groups[j].number_of_terms; k++)
-				file >> (*meshless_datasets)[i].groups[j].h_constraints[k].weight;
-
-		int has_radii;
-		file >> has_radii;
-		for(int j = 0; j != (*meshless_datasets)[i].number_of_groups; j++)
-		{
-			if(has_radii)
-			{
-				(*meshless_datasets)[i].groups[j].h_radii = new float[(*meshless_datasets)[i].groups[j].number_of_terms];
-				for(int k = 0; k != (*meshless_datasets)[i].groups[j].number_of_terms; k++) file >> (*meshless_datasets)[i].groups[j].h_radii[k];
-			}
-			else
-			{
-				(*meshless_datasets)[i].groups[j].h_radii = 0;
-			}
-		}
-	}
-}
-
-void save_meshless_datasets_to_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets)
-{
-	std::ofstream file(filename);
-
-	file << number_of_datasets << std::endl;
-	if(number_of_datasets == 0)	return;	
-
-	for(int i = 0; i != number_of_datasets; i++) {
-
-		file << meshless_datasets[i].number_of_groups << std::endl;
-
-		for(int j = 0; j != meshless_datasets[i].number_of_groups; j++) {
-			file << meshless_datasets[i].groups[j].number_of_terms << " ";
-
-			//todo: handle parameters
-			int parameters = 0;	//0 if none, 1 if each bf has a parameter, 2 if all are the same
-			if(meshless_datasets[i].groups[j].basis_function_id == SPH)                 file << "sph";
-			else if(meshless_datasets[i].groups[j].basis_function_id == GAUSSIAN)       file << "gaussian";
-			else if(meshless_datasets[i].groups[j].basis_function_id == WENDLAND_D3_C2) file << "wendland_d3_c2";
-
-			file << " unused " << parameters << std::endl;
-		}
-		
-		for(int j = 0; j != meshless_datasets[i].number_of_groups; j++)
-			for(int k = 0; k != meshless_datasets[i].groups[j].number_of_terms; k++) 
-				file << meshless_datasets[i].groups[j].h_constraints[k].position.x << " " << meshless_datasets[i].groups[j].h_constraints[k].position.y << " "  << meshless_datasets[i].groups[j].h_constraints[k].position.z << std::endl;
-	
-		for(int j = 0; j != meshless_datasets[i].number_of_groups; j++)
-			for(int k = 0; k != meshless_datasets[i].groups[j].number_of_terms; k++) 
-				file << meshless_datasets[i].groups[j].h_constraints[k].weight << std::endl;
-
-		if(meshless_datasets[0].number_of_groups > 0 && meshless_datasets[0].groups[0].h_radii != 0)
-		{
-			file << 1 << std::endl;
-			for(int j = 0; j != meshless_datasets[i].number_of_groups; j++)
-				for(int k = 0; k != meshless_datasets[i].groups[j].number_of_terms; k++)
-					file << meshless_datasets[i].groups[j].h_radii[k] << std::endl;
-		}
-		else file << 0 << std::endl;
-	}
-}
-
-
+/*
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "meshless.h"
+#ifdef _LIBMESHLESSVIS_USE_CPU
+#include "meshless_vis.h"
+#endif
+#include "entropy_coding.h"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <locale>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct MeshlessMapping
+{
+	void* address;
+	size_t length;
+	// one reference per dataset pointing into the mapping
+	int references;
+};
+
+MeshlessDataset get_simple_meshless_dataset(int number_of_terms, Constraint* h_constraints, float* h_radii, BasisFunctionId basis_function_id)
+{
+	MeshlessDataset meshless_dataset;
+	meshless_dataset.number_of_groups = 1;
+	meshless_dataset.generation = 0;
+	meshless_dataset.mapping = 0;
+	meshless_dataset.groups = new Group[1];
+	meshless_dataset.groups[0].basis_function_id = basis_function_id;
+	meshless_dataset.groups[0].number_of_terms = number_of_terms;
+	meshless_dataset.groups[0].h_constraints = h_constraints;
+	meshless_dataset.groups[0].h_radii = h_radii;
+	return meshless_dataset;
+}
+
+static void release_mapping(MeshlessMapping* mapping);
+
+void delete_meshless_dataset(MeshlessDataset meshless_dataset)
+{
+	if(meshless_dataset.mapping != 0) release_mapping(meshless_dataset.mapping);
+	else for(int i = 0; i != meshless_dataset.number_of_groups; i++)
+	{
+		delete[] meshless_dataset.groups[i].h_constraints;
+		if(meshless_dataset.groups[i].h_radii != 0) delete[] meshless_dataset.groups[i].h_radii;
+	}
+	delete[] meshless_dataset.groups;
+}
+
+void delete_meshless_datasets(MeshlessDataset* meshless_datasets, int number_of_datasets)
+{
+	for(int i = 0; i != number_of_datasets; i++)
+	{
+		delete_meshless_dataset(meshless_datasets[i]);
+	}
+	delete[] meshless_datasets;
+}
+
+int get_number_of_terms(MeshlessDataset* meshless_dataset)
+{
+	int N = 0;
+	for(int i = 0; i != meshless_dataset->number_of_groups; i++)
+	{
+		N += meshless_dataset->groups[i].number_of_terms;
+	}
+	return N;
+}
+
+void shift_meshless_dataset(MeshlessDataset* meshless_dataset, float x, float y, float z)
+{
+	for(int j = 0; j != meshless_dataset->number_of_groups; j++)
+	{
+		for(int k = 0; k != meshless_dataset->groups[j].number_of_terms; k++)
+		{
+			meshless_dataset->groups[j].h_constraints[k].position.x += x;
+			meshless_dataset->groups[j].h_constraints[k].position.y += y;
+			meshless_dataset->groups[j].h_constraints[k].position.z += z;
+		}
+	}
+	meshless_dataset->generation++;
+}
+
+void shift_meshless_datasets(MeshlessDataset* meshless_datasets, int number_of_datasets, float x, float y, float z)
+{
+	for(int i = 0; i != number_of_datasets; ++i) shift_meshless_dataset(meshless_datasets+i, x,y,z);
+}
+
+static const char binary_magic[8] = {'M', 'L', 'S', 'V', 'B', 'I', 'N', 0};
+static const unsigned int binary_version = 1;
+static const size_t binary_alignment = 64;
+static const size_t binary_group_record_size = 32;
+
+// a Constraint must be exactly the 16 byte record of the file for the arrays to be used in place
+typedef char constraint_matches_binary_record[sizeof(Constraint) == 16 ? 1 : -1];
+
+static bool host_is_little_endian()
+{
+	const unsigned int one = 1;
+	return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+static void swap_bytes(void* data, size_t size, size_t count)
+{
+	unsigned char* bytes = static_cast<unsigned char*>(data);
+	for(size_t i = 0; i != count; i++, bytes += size)
+		for(size_t j = 0; j != size/2; j++) std::swap(bytes[j], bytes[size-1-j]);
+}
+
+static unsigned int read_uint32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned long long read_uint64(const unsigned char* p)
+{
+	return read_uint32(p) | ((unsigned long long)read_uint32(p+4) << 32);
+}
+
+static void write_uint32(unsigned char* p, unsigned int value)
+{
+	for(int i = 0; i != 4; i++) p[i] = (unsigned char)(value >> (8*i));
+}
+
+static void write_uint64(unsigned char* p, unsigned long long value)
+{
+	for(int i = 0; i != 8; i++) p[i] = (unsigned char)(value >> (8*i));
+}
+
+static size_t align_offset(size_t offset)
+{
+	return (offset + binary_alignment-1) / binary_alignment * binary_alignment;
+}
+
+static MeshlessMapping* map_file(const char* filename)
+{
+	MeshlessMapping* mapping = new MeshlessMapping;
+	mapping->references = 0;
+#ifdef WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	LARGE_INTEGER length;
+	if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &length) || length.QuadPart == 0)
+	{
+		if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		delete mapping;
+		return 0;
+	}
+	// copy-on-write, so that the arrays can be modified in place without touching the file
+	HANDLE file_mapping = CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+	mapping->address = file_mapping != 0 ? MapViewOfFile(file_mapping, FILE_MAP_COPY, 0, 0, 0) : 0;
+	mapping->length = (size_t)length.QuadPart;
+	if(file_mapping != 0) CloseHandle(file_mapping);
+	CloseHandle(file);
+	if(mapping->address == 0)
+	{
+		delete mapping;
+		return 0;
+	}
+#else
+	int file = open(filename, O_RDONLY);
+	struct stat status;
+	if(file < 0 || fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		if(file >= 0) close(file);
+		delete mapping;
+		return 0;
+	}
+	mapping->length = (size_t)status.st_size;
+	mapping->address = mmap(0, mapping->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	close(file);
+	if(mapping->address == MAP_FAILED)
+	{
+		delete mapping;
+		return 0;
+	}
+#endif
+	return mapping;
+}
+
+static void unmap_file(MeshlessMapping* mapping)
+{
+#ifdef WIN32
+	UnmapViewOfFile(mapping->address);
+#else
+	munmap(mapping->address, mapping->length);
+#endif
+	delete mapping;
+}
+
+static void release_mapping(MeshlessMapping* mapping)
+{
+	bool unused;
+	#pragma omp critical(meshless_mapping_references)
+	unused = --mapping->references == 0;
+	if(unused) unmap_file(mapping);
+}
+
+static bool file_starts_with(const char* filename, const char (&magic)[8])
+{
+	std::ifstream file(filename, std::ios::binary);
+	char start[sizeof(magic)];
+	return file.read(start, sizeof(start)) && std::memcmp(start, magic, sizeof(start)) == 0;
+}
+
+bool is_binary_meshless_file(const char* filename)
+{
+	return file_starts_with(filename, binary_magic);
+}
+
+// the number of timesteps of a mapped binary file, or -1 if its header isn't valid
+static int binary_number_of_datasets(const MeshlessMapping* mapping)
+{
+	const unsigned char* file = static_cast<const unsigned char*>(mapping->address);
+	if(mapping->length < 16 || std::memcmp(file, binary_magic, sizeof(binary_magic)) != 0 || read_uint32(file+8) != binary_version) return -1;
+	const unsigned int n = read_uint32(file+12);
+	return n <= 0x7fffffff && 16 + 8ull*n <= mapping->length ? (int)n : -1;
+}
+
+// Points the groups of timestep k of a mapped binary file straight into the mapping, in the byte order of the file.  Returns false,
+// leaving no groups, if its records aren't valid.
+static bool map_binary_dataset(const MeshlessMapping* mapping, int k, MeshlessDataset& dataset)
+{
+	unsigned char* file = static_cast<unsigned char*>(mapping->address);
+	const unsigned long long length = mapping->length;
+	dataset.number_of_groups = 0;
+	dataset.groups = 0;
+
+	const unsigned long long timestep_offset = read_uint64(file + 16 + 8*k);
+	if(timestep_offset % binary_alignment != 0 || timestep_offset + 8 > length) return false;
+	const unsigned long long number_of_groups = read_uint32(file+timestep_offset);
+	if(number_of_groups > 0x7fffffff || timestep_offset + 8 + number_of_groups*binary_group_record_size > length) return false;
+
+	Group* groups = new Group[number_of_groups];
+	std::memset(groups, 0, number_of_groups*sizeof(Group));
+	for(unsigned long long j = 0; j != number_of_groups; j++)
+	{
+		const unsigned char* record = file + timestep_offset + 8 + j*binary_group_record_size;
+		const unsigned long long number_of_terms = read_uint64(record);
+		const unsigned int basis_function_id = read_uint32(record+8);
+		const bool has_radii = read_uint32(record+12) != 0;
+		const unsigned long long constraints_offset = read_uint64(record+16);
+		const unsigned long long radii_offset = read_uint64(record+24);
+
+		const bool valid = number_of_terms <= 0x7fffffff && basis_function_id <= WENDLAND_D3_C2
+			&& constraints_offset % binary_alignment == 0 && constraints_offset <= length && number_of_terms*sizeof(Constraint) <= length - constraints_offset
+			&& (!has_radii || (radii_offset % binary_alignment == 0 && radii_offset <= length && number_of_terms*sizeof(float) <= length - radii_offset));
+		if(!valid)
+		{
+			delete[] groups;
+			return false;
+		}
+
+		groups[j].number_of_terms = (int)number_of_terms;
+		groups[j].basis_function_id = (BasisFunctionId)basis_function_id;
+		groups[j].h_constraints = reinterpret_cast<Constraint*>(file + constraints_offset);
+		groups[j].h_radii = has_radii ? reinterpret_cast<float*>(file + radii_offset) : 0;
+	}
+	dataset.number_of_groups = (int)number_of_groups;
+	dataset.groups = groups;
+	return true;
+}
+
+static void swap_group_bytes(Group& group)
+{
+	swap_bytes(group.h_constraints, sizeof(float), 4*(size_t)group.number_of_terms);
+	if(group.h_radii != 0) swap_bytes(group.h_radii, sizeof(float), group.number_of_terms);
+}
+
+bool load_meshless_datasets_from_binary_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets)
+{
+	*meshless_datasets = 0;
+	*number_of_datasets = 0;
+
+	MeshlessMapping* mapping = map_file(filename);
+	if(mapping == 0) return false;
+
+	const int n = binary_number_of_datasets(mapping);
+	if(n <= 0)
+	{
+		unmap_file(mapping);
+		return n == 0;
+	}
+
+	MeshlessDataset* datasets = new MeshlessDataset[n];
+	for(int i = 0; i != n; i++)
+	{
+		datasets[i].generation = 0;
+		datasets[i].mapping = mapping;
+		if(!map_binary_dataset(mapping, i, datasets[i]))
+		{
+			for(int j = 0; j != i; j++) delete[] datasets[j].groups;
+			delete[] datasets;
+			unmap_file(mapping);
+			return false;
+		}
+	}
+	if(!host_is_little_endian())
+		for(int i = 0; i != n; i++)
+			for(int j = 0; j != datasets[i].number_of_groups; j++) swap_group_bytes(datasets[i].groups[j]);
+
+	mapping->references = n;
+	*meshless_datasets = datasets;
+	*number_of_datasets = n;
+	return true;
+}
+
+// the start of the range is rounded down to a page, the mapping itself starts on one
+static void prefetch_mapped_range(const MeshlessMapping* mapping, const void* address, size_t length)
+{
+	size_t offset = static_cast<const char*>(address) - static_cast<const char*>(mapping->address);
+#ifdef WIN32
+#if _WIN32_WINNT >= 0x0602
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	size_t page_offset = offset / system_info.dwPageSize * system_info.dwPageSize;
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = static_cast<char*>(mapping->address) + page_offset;
+	range.NumberOfBytes = offset + length - page_offset;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	size_t page_offset = offset / page_size * page_size;
+	madvise(static_cast<char*>(mapping->address) + page_offset, offset + length - page_offset, MADV_WILLNEED);
+#endif
+}
+
+void meshless_dataset_prefetch_terms(MeshlessDataset* meshless_dataset, int group, int first_term, int number_of_terms)
+{
+	if(meshless_dataset->mapping == 0) return;
+	const Group& prefetched = meshless_dataset->groups[group];
+	first_term = std::max(0, first_term);
+	number_of_terms = std::min(number_of_terms, prefetched.number_of_terms - first_term);
+	if(number_of_terms <= 0) return;
+
+	prefetch_mapped_range(meshless_dataset->mapping, prefetched.h_constraints + first_term, sizeof(Constraint)*(size_t)number_of_terms);
+	if(prefetched.h_radii != 0) prefetch_mapped_range(meshless_dataset->mapping, prefetched.h_radii + first_term, sizeof(float)*(size_t)number_of_terms);
+}
+
+bool save_meshless_datasets_to_binary_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if(!file) return false;
+
+	// lay the file out first, the header and group records need the offsets of what comes after them
+	std::vector<unsigned char> header(align_offset(16 + 8*(size_t)number_of_datasets), 0);
+	std::memcpy(&header[0], binary_magic, sizeof(binary_magic));
+	write_uint32(&header[8], binary_version);
+	write_uint32(&header[12], number_of_datasets);
+
+	std::vector<std::vector<unsigned char> > timesteps(number_of_datasets);
+	unsigned long long offset = header.size();
+	for(int i = 0; i != number_of_datasets; i++)
+	{
+		const MeshlessDataset& dataset = meshless_datasets[i];
+		write_uint64(&header[16 + 8*i], offset);
+		timesteps[i].assign(align_offset(8 + dataset.number_of_groups*binary_group_record_size), 0);
+		write_uint32(&timesteps[i][0], dataset.number_of_groups);
+		offset += timesteps[i].size();
+		for(int j = 0; j != dataset.number_of_groups; j++)
+		{
+			const Group& group = dataset.groups[j];
+			unsigned char* record = &timesteps[i][8 + j*binary_group_record_size];
+			write_uint64(record, group.number_of_terms);
+			write_uint32(record+8, group.basis_function_id);
+			write_uint32(record+12, group.h_radii != 0);
+			write_uint64(record+16, offset);
+			offset += align_offset(group.number_of_terms*sizeof(Constraint));
+			write_uint64(record+24, group.h_radii != 0 ? offset : 0);
+			if(group.h_radii != 0) offset += align_offset(group.number_of_terms*sizeof(float));
+		}
+	}
+
+	const bool swap = !host_is_little_endian();
+	const char padding[binary_alignment] = {0};
+	std::vector<float> swapped;
+	file.write(reinterpret_cast<const char*>(&header[0]), header.size());
+	for(int i = 0; i != number_of_datasets; i++)
+	{
+		const MeshlessDataset& dataset = meshless_datasets[i];
+		file.write(reinterpret_cast<const char*>(&timesteps[i][0]), timesteps[i].size());
+		for(int j = 0; j != dataset.number_of_groups; j++)
+		{
+			const Group& group = dataset.groups[j];
+			for(int k = 0; k != (group.h_radii != 0 ? 2 : 1); k++)
+			{
+				const float* data = k == 0 ? &group.h_constraints[0].position.x : group.h_radii;
+				const size_t count = k == 0 ? 4*(size_t)group.number_of_terms : group.number_of_terms;
+				if(swap)
+				{
+					swapped.assign(data, data+count);
+					if(count != 0) swap_bytes(&swapped[0], sizeof(float), count);
+					data = count != 0 ? &swapped[0] : data;
+				}
+				file.write(reinterpret_cast<const char*>(data), count*sizeof(float));
+				file.write(padding, align_offset(count*sizeof(float)) - count*sizeof(float));
+			}
+		}
+	}
+	return (bool)file;
+}
+
+// The text format is a stream of whitespace separated tokens, read as if by iostreams in the classic locale.  It is parsed from a
+// mapping of the file, which is cut into chunks of about text_chunk_size bytes at whitespace.  A parallel pass counts the tokens of
+// each chunk, so that the token at any index can be found without parsing what comes before it, and the chunks of the long numeric
+// sections are then parsed by their own threads straight into the arrays of the groups.
+
+static const size_t text_chunk_size = 1 << 20;
+static const int text_lines_per_chunk = 1 << 16;
+
+static const double powers_of_ten[51] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+	1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22, 1e23, 1e24, 1e25,
+	1e26, 1e27, 1e28, 1e29, 1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38,
+	1e39, 1e40, 1e41, 1e42, 1e43, 1e44, 1e45, 1e46, 1e47, 1e48, 1e49, 1e50
+};
+
+static inline bool is_space(char c)
+{
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static const char* skip_space(const char* p, const char* end)
+{
+	while(p != end && is_space(*p)) p++;
+	return p;
+}
+
+static const char* token_end(const char* p, const char* end)
+{
+	while(p != end && !is_space(*p)) p++;
+	return p;
+}
+
+// what operator>> would give for the token, used for whatever parse_float can't convert exactly
+static float parse_float_slowly(const char* begin, const char* end)
+{
+	std::istringstream stream(std::string(begin, end));
+	stream.imbue(std::locale::classic());
+	float value = 0.0f;
+	stream >> value;
+	return value;
+}
+
+// Converts the token [begin, end) to the nearest float, like strtof in the classic locale.  Tokens with up to 19 significant digits
+// and a moderate exponent are converted with one correctly rounded double operation, which gives the nearest float too unless the
+// double lands exactly halfway between two floats, the rest go through parse_float_slowly.
+static float parse_float(const char* begin, const char* end)
+{
+	const char* p = begin;
+	const bool negative = p != end && *p == '-';
+	if(p != end && (*p == '-' || *p == '+')) p++;
+
+	unsigned long long mantissa = 0;
+	int significant_digits = 0, exponent = 0;
+	bool any_digits = false;
+	for(; p != end && *p >= '0' && *p <= '9'; p++, any_digits = true)
+	{
+		if(mantissa == 0 && *p == '0') continue;
+		if(significant_digits++ < 19) mantissa = 10*mantissa + (*p - '0');
+		else exponent++;
+	}
+	if(p != end && *p == '.')
+	{
+		for(p++; p != end && *p >= '0' && *p <= '9'; p++, any_digits = true)
+		{
+			if(mantissa == 0 && *p == '0')
+			{
+				exponent--;
+				continue;
+			}
+			if(significant_digits++ < 19) mantissa = 10*mantissa + (*p - '0'), exponent--;
+		}
+	}
+	if(p != end && any_digits && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		const bool negative_exponent = p != end && *p == '-';
+		if(p != end && (*p == '-' || *p == '+')) p++;
+		if(p == end) return parse_float_slowly(begin, end);
+		int e = 0;
+		for(; p != end && *p >= '0' && *p <= '9'; p++) e = std::min(10*e + (*p - '0'), 100000);
+		exponent += negative_exponent ? -e : e;
+	}
+	if(p != end || !any_digits || significant_digits > 19) return parse_float_slowly(begin, end);
+	if(mantissa == 0) return negative ? -0.0f : 0.0f;
+
+	if(mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22)
+	{
+		const double value = exponent < 0 ? (double)mantissa / powers_of_ten[-exponent] : (double)mantissa * powers_of_ten[exponent];
+		unsigned long long bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const bool halfway = (bits & ((1ull << 29) - 1)) == (1ull << 28);
+		if(value >= FLT_MIN && value <= FLT_MAX && !halfway) return negative ? -(float)value : (float)value;
+	}
+	return parse_float_slowly(begin, end);
+}
+
+static long long parse_integer(const char* begin, const char* end)
+{
+	const char* p = begin;
+	const bool negative = p != end && *p == '-';
+	if(p != end && (*p == '-' || *p == '+')) p++;
+	long long value = 0;
+	for(; p != end && *p >= '0' && *p <= '9'; p++) value = 10*value + (*p - '0');
+	return negative ? -value : value;
+}
+
+static std::string next_token(const char*& p, const char* end, long long& token)
+{
+	const char* q = token_end(p, end);
+	const std::string value(p, q);
+	p = skip_space(q, end);
+	token++;
+	return value;
+}
+
+static int next_integer(const char*& p, const char* end, long long& token)
+{
+	const int value = (int)parse_integer(p, token_end(p, end));
+	next_token(p, end, token);
+	return value;
+}
+
+struct TextChunk
+{
+	const char* begin, *end;
+	long long first_token;
+};
+
+class TextTokens
+{
+public:
+	TextTokens(const char* begin, const char* end) : file_end(end), number_of_tokens(0)
+	{
+		const int number_of_chunks = (int)((end - begin + text_chunk_size-1) / text_chunk_size);
+		chunks.resize(number_of_chunks);
+
+		// chunks start at whitespace so that no token is split between two
+		for(int i = 0; i != number_of_chunks; i++)
+		{
+			const char* p = begin + i*text_chunk_size;
+			chunks[i].begin = i == 0 ? begin : std::find_if(p, end, is_space);
+		}
+		std::vector<long long> number_of_chunk_tokens(number_of_chunks);
+#ifdef _LIBMESHLESSVIS_USE_CPU
+		#pragma omp parallel for schedule(dynamic) num_threads(vis_get_number_of_threads())
+#else
+		#pragma omp parallel for schedule(dynamic)
+#endif
+		for(int i = 0; i < number_of_chunks; i++)
+		{
+			chunks[i].end = i+1 != number_of_chunks ? chunks[i+1].begin : end;
+			long long n = 0;
+			for(const char* p = skip_space(chunks[i].begin, chunks[i].end); p != chunks[i].end; p = skip_space(token_end(p, chunks[i].end), chunks[i].end)) n++;
+			number_of_chunk_tokens[i] = n;
+		}
+		for(int i = 0; i != number_of_chunks; i++)
+		{
+			chunks[i].first_token = number_of_tokens;
+			number_of_tokens += number_of_chunk_tokens[i];
+		}
+	}
+
+	long long size() const
+	{
+		return number_of_tokens;
+	}
+
+	const char* end() const
+	{
+		return file_end;
+	}
+
+	// the start of the token with this index, or the end of the file if there are fewer tokens
+	const char* find(long long token) const
+	{
+		if(token >= number_of_tokens) return file_end;
+		const TextChunk& chunk = *(std::upper_bound(chunks.begin(), chunks.end(), token, starts_after) - 1);
+		const char* p = skip_space(chunk.begin, chunk.end);
+		for(long long i = chunk.first_token; i != token; i++) p = skip_space(token_end(p, chunk.end), chunk.end);
+		return p;
+	}
+
+	// parses count floats from the first token on, calling sink(i, value) with i counted from first
+	template<class Sink> void parse_floats(long long first, long long count, const Sink& sink) const
+	{
+		const long long last = std::min(first + count, number_of_tokens);
+		if(first >= last) return;
+		const int first_chunk = (int)(std::upper_bound(chunks.begin(), chunks.end(), first, starts_after) - chunks.begin()) - 1;
+		const int last_chunk = (int)(std::upper_bound(chunks.begin(), chunks.end(), last-1, starts_after) - chunks.begin());
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+		#pragma omp parallel for schedule(dynamic) num_threads(vis_get_number_of_threads())
+#else
+		#pragma omp parallel for schedule(dynamic)
+#endif
+		for(int i = first_chunk; i < last_chunk; i++)
+		{
+			const TextChunk& chunk = chunks[i];
+			const char* p = skip_space(chunk.begin, chunk.end);
+			long long token = chunk.first_token;
+			for(; token < first; token++) p = skip_space(token_end(p, chunk.end), chunk.end);
+			for(; token < last && p != chunk.end; token++)
+			{
+				const char* q = token_end(p, chunk.end);
+				sink(token - first, parse_float(p, q));
+				p = skip_space(q, chunk.end);
+			}
+		}
+	}
+
+private:
+	static bool starts_after(long long token, const TextChunk& chunk)
+	{
+		return token < chunk.first_token;
+	}
+
+	std::vector<TextChunk> chunks;
+	const char* file_end;
+	long long number_of_tokens;
+};
+
+// Where the tokens of a numeric section go: the section lists the terms of all the groups of a timestep in order, with components
+// values per term, stored stride floats apart from the component'th float of the group's array.
+struct TextSection
+{
+	struct Segment
+	{
+		long long first_value;
+		float* data;
+	};
+
+	TextSection(int components, int stride) : components(components), stride(stride), number_of_values(0)
+	{
+	}
+
+	void add_group(float* data, int number_of_terms)
+	{
+		Segment segment = {number_of_values, data};
+		segments.push_back(segment);
+		number_of_values += (long long)components*number_of_terms;
+	}
+
+	void operator()(long long value_index, float value) const
+	{
+		int s = (int)segments.size() - 1;
+		while(segments[s].first_value > value_index) s--;
+		const long long i = value_index - segments[s].first_value;
+		segments[s].data[(i / components)*stride + i % components] = value;
+	}
+
+	std::vector<Segment> segments;
+	int components, stride;
+	long long number_of_values;
+};
+
+// Loads the timestep starting at the given token and moves token past it.
+static void load_text_dataset(const TextTokens& tokens, long long& token, MeshlessDataset& dataset)
+{
+	// the header tokens are few and read one after another, p is the start of the token with index token
+	const char* p = tokens.find(token);
+	const char* end = tokens.end();
+
+	dataset.number_of_groups = std::max(0, next_integer(p, end, token));
+	dataset.generation = 0;
+	dataset.mapping = 0;
+	dataset.groups = new Group[dataset.number_of_groups];
+	for(int j = 0; j != dataset.number_of_groups; j++)
+	{
+		dataset.groups[j].number_of_terms = std::max(0, next_integer(p, end, token));
+
+		const std::string basis_function_name = next_token(p, end, token);
+		if(basis_function_name == "sph")                 dataset.groups[j].basis_function_id = SPH;
+		else if(basis_function_name == "gaussian")       dataset.groups[j].basis_function_id = GAUSSIAN;
+		else if(basis_function_name == "wendland_d3_c2") dataset.groups[j].basis_function_id = WENDLAND_D3_C2;
+
+		next_token(p, end, token);	// operator
+
+		//todo: handle parameters
+		next_token(p, end, token);	// 0 if none, 1 if each bf has a parameter, 2 if all are the same
+	}
+
+	// positions, then weights, then whether there are radii, then the radii
+	TextSection positions(3, 4), weights(1, 4), radii(1, 1);
+	for(int j = 0; j != dataset.number_of_groups; j++)
+	{
+		dataset.groups[j].h_constraints = new Constraint[dataset.groups[j].number_of_terms];
+		positions.add_group(&dataset.groups[j].h_constraints[0].position.x, dataset.groups[j].number_of_terms);
+		weights.add_group(&dataset.groups[j].h_constraints[0].weight, dataset.groups[j].number_of_terms);
+	}
+	tokens.parse_floats(token, positions.number_of_values, positions);
+	tokens.parse_floats(token + positions.number_of_values, weights.number_of_values, weights);
+	token += positions.number_of_values + weights.number_of_values;
+	p = tokens.find(token);
+
+	const int has_radii = next_integer(p, end, token);
+	for(int j = 0; j != dataset.number_of_groups; j++)
+	{
+		dataset.groups[j].h_radii = has_radii ? new float[dataset.groups[j].number_of_terms] : 0;
+		if(has_radii) radii.add_group(dataset.groups[j].h_radii, dataset.groups[j].number_of_terms);
+	}
+	tokens.parse_floats(token, radii.number_of_values, radii);
+	token += radii.number_of_values;
+}
+
+// Moves token past the timestep starting there, reading only its header.
+static void skip_text_dataset(const TextTokens& tokens, long long& token)
+{
+	const char* p = tokens.find(token);
+	const char* end = tokens.end();
+
+	const int number_of_groups = next_integer(p, end, token);
+	long long number_of_terms = 0;
+	for(int j = 0; j < number_of_groups; j++)
+	{
+		number_of_terms += std::max(0, next_integer(p, end, token));
+		for(int k = 0; k != 3; k++) next_token(p, end, token);
+	}
+	token += 4*number_of_terms;
+	p = tokens.find(token);
+	if(next_integer(p, end, token)) token += number_of_terms;
+}
+
+void load_meshless_datasets_from_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets)
+{
+	if(is_binary_meshless_file(filename))
+	{
+		if(!load_meshless_datasets_from_binary_file(filename, meshless_datasets, number_of_datasets)) std::cerr << "invalid binary dataset file " << filename << std::endl;
+		return;
+	}
+	if(is_compressed_meshless_file(filename))
+	{
+		if(!load_meshless_datasets_from_compressed_file(filename, meshless_datasets, number_of_datasets)) std::cerr << "invalid compressed dataset file " << filename << std::endl;
+		return;
+	}
+
+	*meshless_datasets = 0;
+	*number_of_datasets = 0;
+	MeshlessMapping* mapping = map_file(filename);
+	if(mapping == 0) return;
+
+	const char* file = static_cast<const char*>(mapping->address);
+	const TextTokens tokens(file, file + mapping->length);
+
+	long long token = 0;
+	const char* p = tokens.find(token);
+	*number_of_datasets = std::max(0, next_integer(p, tokens.end(), token));
+	if(*number_of_datasets != 0)
+	{
+		(*meshless_datasets) = new MeshlessDataset[*number_of_datasets];
+		for(int i = 0; i != *number_of_datasets; i++) load_text_dataset(tokens, token, (*meshless_datasets)[i]);
+	}
+
+	unmap_file(mapping);
+}
+
+// Formats the value the way operator<< does with the default precision of 6, i.e. like printf's %g.  The value is scaled to six
+// digits in double precision, which is accurate to well within 1e-7 of a unit, so only values that land that close to halfway
+// between two six digit decimals go through sprintf to get the rounding right.
+static char* format_float(char* out, float value)
+{
+	const double magnitude = std::fabs((double)value);
+	if(magnitude == 0.0 || !(magnitude <= FLT_MAX))
+	{
+		char buffer[32];
+		std::sprintf(buffer, "%g", (double)value);
+		for(const char* c = buffer; *c != 0; c++) *out++ = *c;
+		return out;
+	}
+
+	int exponent = (int)std::floor(std::log10(magnitude));
+	double scaled;
+	for(;;)
+	{
+		scaled = 5-exponent >= 0 ? magnitude * powers_of_ten[5-exponent] : magnitude / powers_of_ten[exponent-5];
+		if(scaled < 100000.0) exponent--;
+		else if(scaled >= 1000000.0) exponent++;
+		else break;
+	}
+	const double fraction = scaled - std::floor(scaled);
+	if(std::fabs(fraction - 0.5) < 1e-7)
+	{
+		char buffer[32];
+		std::sprintf(buffer, "%g", (double)value);
+		for(char* c = buffer; *c != 0; c++) *out++ = *c == ',' ? '.' : *c;
+		return out;
+	}
+	int digits = (int)std::floor(scaled + 0.5);
+	if(digits == 1000000) digits = 100000, exponent++;
+
+	char digit[6];
+	for(int i = 5; i >= 0; i--, digits /= 10) digit[i] = (char)('0' + digits % 10);
+	int number_of_digits = 6;
+	while(number_of_digits > 1 && digit[number_of_digits-1] == '0') number_of_digits--;
+
+	if(value < 0.0f) *out++ = '-';
+	if(exponent < -4 || exponent >= 6)
+	{
+		*out++ = digit[0];
+		if(number_of_digits > 1) *out++ = '.';
+		for(int i = 1; i < number_of_digits; i++) *out++ = digit[i];
+		*out++ = 'e';
+		*out++ = exponent < 0 ? '-' : '+';
+		const int e = std::abs(exponent);
+		if(e >= 100) *out++ = (char)('0' + e/100);
+		*out++ = (char)('0' + e/10 % 10);
+		*out++ = (char)('0' + e % 10);
+	}
+	else if(exponent >= 0)
+	{
+		for(int i = 0; i <= exponent; i++) *out++ = digit[i];
+		if(number_of_digits > exponent+1) *out++ = '.';
+		for(int i = exponent+1; i < number_of_digits; i++) *out++ = digit[i];
+	}
+	else
+	{
+		*out++ = '0';
+		*out++ = '.';
+		for(int i = -1; i > exponent; i--) *out++ = '0';
+		for(int i = 0; i < number_of_digits; i++) *out++ = digit[i];
+	}
+	return out;
+}
+
+// Writes one numeric section of a timestep, a line per term of each group in order, formatting text_lines_per_chunk lines per thread
+// at a time.
+static void save_text_section(std::ofstream& file, const MeshlessDataset& dataset, int section)
+{
+	std::vector<long long> first_term(dataset.number_of_groups+1, 0);
+	for(int j = 0; j != dataset.number_of_groups; j++) first_term[j+1] = first_term[j] + dataset.groups[j].number_of_terms;
+	const long long number_of_terms = first_term[dataset.number_of_groups];
+
+	const int number_of_chunks = (int)((number_of_terms + text_lines_per_chunk-1) / text_lines_per_chunk);
+	const int chunks_per_batch = 64;
+	std::vector<std::string> text(std::min(number_of_chunks, chunks_per_batch));
+	for(int batch = 0; batch < number_of_chunks; batch += chunks_per_batch)
+	{
+		const int batch_size = std::min(chunks_per_batch, number_of_chunks - batch);
+#ifdef _LIBMESHLESSVIS_USE_CPU
+		#pragma omp parallel for schedule(dynamic) num_threads(vis_get_number_of_threads())
+#else
+		#pragma omp parallel for schedule(dynamic)
+#endif
+		for(int c = 0; c < batch_size; c++)
+		{
+			const long long begin = (long long)(batch + c)*text_lines_per_chunk;
+			const long long end = std::min(begin + text_lines_per_chunk, number_of_terms);
+			text[c].resize((size_t)(end - begin)*(section == 0 ? 48 : 16));
+			char* out = text[c].empty() ? 0 : &text[c][0];
+			int j = (int)(std::upper_bound(first_term.begin(), first_term.end(), begin) - first_term.begin()) - 1;
+			for(long long t = begin; t != end; t++)
+			{
+				while(t >= first_term[j+1]) j++;
+				const Group& group = dataset.groups[j];
+				const long long k = t - first_term[j];
+				if(section == 0)
+				{
+					out = format_float(out, group.h_constraints[k].position.x);
+					*out++ = ' ';
+					out = format_float(out, group.h_constraints[k].position.y);
+					*out++ = ' ';
+					out = format_float(out, group.h_constraints[k].position.z);
+				}
+				else out = format_float(out, section == 1 ? group.h_constraints[k].weight : group.h_radii[k]);
+				*out++ = '\n';
+			}
+			text[c].resize(out - (text[c].empty() ? 0 : &text[c][0]));
+		}
+		for(int c = 0; c != batch_size; c++) file.write(text[c].data(), text[c].size());
+	}
+}
+
+void save_meshless_datasets_to_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets)
+{
+	std::ofstream file(filename);
+
+	file << number_of_datasets << '\n';
+	if(number_of_datasets == 0)	return;
+
+	for(int i = 0; i != number_of_datasets; i++) {
+
+		file << meshless_datasets[i].number_of_groups << '\n';
+
+		for(int j = 0; j != meshless_datasets[i].number_of_groups; j++) {
+			file << meshless_datasets[i].groups[j].number_of_terms << " ";
+
+			//todo: handle parameters
+			int parameters = 0;	//0 if none, 1 if each bf has a parameter, 2 if all are the same
+			if(meshless_datasets[i].groups[j].basis_function_id == SPH)                 file << "sph";
+			else if(meshless_datasets[i].groups[j].basis_function_id == GAUSSIAN)       file << "gaussian";
+			else if(meshless_datasets[i].groups[j].basis_function_id == WENDLAND_D3_C2) file << "wendland_d3_c2";
+
+			file << " unused " << parameters << '\n';
+		}
+
+		save_text_section(file, meshless_datasets[i], 0);
+		save_text_section(file, meshless_datasets[i], 1);
+
+		if(meshless_datasets[0].number_of_groups > 0 && meshless_datasets[0].groups[0].h_radii != 0)
+		{
+			file << 1 << '\n';
+			save_text_section(file, meshless_datasets[i], 2);
+		}
+		else file << 0 << '\n';
+	}
+}
+
+// The compressed format, see meshless.h.  Each array of a group is cut into blocks of compressed_block_length terms, which are coded
+// independently so that a timestep's blocks are coded and decoded in parallel.  The values of a block are grid coordinates for the
+// positions and the bits of the floats for the weights and radii.  In a keyframe each value is coded relative to the previous one in
+// its block, otherwise relative to the same term of the timestep before: positions as the zigzag encoded difference, weights and radii
+// XORed, so that a weight that stays constant codes as 0.  The four bytes of the results are split into four arrays for entropy_encode.
+
+static const char compressed_magic[8] = {'M', 'L', 'S', 'V', 'C', 'M', 'P', 0};
+static const unsigned int compressed_version = 1;
+static const size_t compressed_header_size = 80;
+static const int compressed_block_length = 1 << 16;
+
+enum CompressedArray
+{
+	X_ARRAY,
+	Y_ARRAY,
+	Z_ARRAY,
+	WEIGHT_ARRAY,
+	RADIUS_ARRAY,
+	NUMBER_OF_COMPRESSED_ARRAYS
+};
+
+struct CompressedHeader
+{
+	int number_of_datasets;
+	int position_bits, keyframe_interval;
+	double grid_origin[3], grid_step[3];
+	float position_error;
+};
+
+struct CompressedBlock
+{
+	int group, array;
+	int first_term, number_of_terms;
+};
+
+// the values of the arrays of each group of the timestep last coded or decoded, indexed by group*NUMBER_OF_COMPRESSED_ARRAYS + array
+typedef std::vector<std::vector<unsigned int> > CompressedState;
+
+static inline unsigned int zigzag(int value)
+{
+	return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static inline int unzigzag(unsigned int value)
+{
+	return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+static double read_double(const unsigned char* p)
+{
+	const unsigned long long bits = read_uint64(p);
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static void write_double(unsigned char* p, double value)
+{
+	unsigned long long bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	write_uint64(p, bits);
+}
+
+static unsigned int quantize(float x, double origin, double step, unsigned int largest)
+{
+	if(step == 0.0) return 0;
+	const double q = std::floor((x - origin) / step + 0.5);
+	return !(q > 0.0) ? 0 : q >= largest ? largest : (unsigned int)q;
+}
+
+static float dequantize(unsigned int q, double origin, double step)
+{
+	return (float)(origin + q*step);
+}
+
+static std::vector<CompressedBlock> list_compressed_blocks(const std::vector<int>& number_of_terms, const std::vector<bool>& has_radii)
+{
+	std::vector<CompressedBlock> blocks;
+	for(int j = 0; j != (int)number_of_terms.size(); j++)
+		for(int a = 0; a != NUMBER_OF_COMPRESSED_ARRAYS; a++)
+		{
+			if(a == RADIUS_ARRAY && !has_radii[j]) continue;
+			for(int first = 0; first < number_of_terms[j]; first += compressed_block_length)
+			{
+				CompressedBlock block = {j, a, first, std::min(compressed_block_length, number_of_terms[j] - first)};
+				blocks.push_back(block);
+			}
+		}
+	return blocks;
+}
+
+static void reset_compressed_state(CompressedState& state, const std::vector<int>& number_of_terms, const std::vector<bool>& has_radii)
+{
+	state.assign(number_of_terms.size()*NUMBER_OF_COMPRESSED_ARRAYS, std::vector<unsigned int>());
+	for(int j = 0; j != (int)number_of_terms.size(); j++)
+		for(int a = 0; a != NUMBER_OF_COMPRESSED_ARRAYS; a++)
+			if(a != RADIUS_ARRAY || has_radii[j]) state[j*NUMBER_OF_COMPRESSED_ARRAYS + a].resize(number_of_terms[j]);
+}
+
+// codes the block, updating the state, and returns the largest error of its positions
+static float encode_compressed_block(const CompressedBlock& block, const MeshlessDataset& dataset, const CompressedHeader& header, bool keyframe, CompressedState& state, std::vector<unsigned char>& coded)
+{
+	const Group& group = dataset.groups[block.group];
+	std::vector<unsigned int>& values = state[block.group*NUMBER_OF_COMPRESSED_ARRAYS + block.array];
+	const int n = block.number_of_terms;
+	const unsigned int largest = (1u << header.position_bits) - 1;
+	std::vector<unsigned char> bytes(4*(size_t)n);
+	float error = 0.0f;
+	unsigned int previous = 0;
+	for(int i = 0; i != n; i++)
+	{
+		const int k = block.first_term + i;
+		const unsigned int reference = keyframe ? previous : values[k];
+		unsigned int value, residual;
+		if(block.array <= Z_ARRAY)
+		{
+			const float x = (&group.h_constraints[k].position.x)[block.array];
+			value = quantize(x, header.grid_origin[block.array], header.grid_step[block.array], largest);
+			error = std::max(error, std::fabs(dequantize(value, header.grid_origin[block.array], header.grid_step[block.array]) - x));
+			residual = zigzag((int)(value - reference));
+		}
+		else
+		{
+			const float x = block.array == WEIGHT_ARRAY ? group.h_constraints[k].weight : group.h_radii[k];
+			std::memcpy(&value, &x, sizeof(value));
+			residual = value ^ reference;
+		}
+		previous = values[k] = value;
+		for(int b = 0; b != 4; b++) bytes[b*n + i] = (unsigned char)(residual >> (8*b));
+	}
+	for(int b = 0; b != 4; b++) entropy_encode(&bytes[b*n], n, coded);
+	return error;
+}
+
+// decodes the block, updating the state, and writes its values into the dataset's arrays unless dataset is 0
+static bool decode_compressed_block(const CompressedBlock& block, const unsigned char* coded, const unsigned char* coded_end, const CompressedHeader& header, bool keyframe, CompressedState& state, MeshlessDataset* dataset)
+{
+	std::vector<unsigned int>& values = state[block.group*NUMBER_OF_COMPRESSED_ARRAYS + block.array];
+	const int n = block.number_of_terms;
+	std::vector<unsigned char> bytes(4*(size_t)n);
+	for(int b = 0; b != 4 && coded != 0; b++) coded = entropy_decode(coded, coded_end, &bytes[b*n], n);
+	if(coded == 0) return false;
+
+	unsigned int previous = 0;
+	for(int i = 0; i != n; i++)
+	{
+		const int k = block.first_term + i;
+		const unsigned int reference = keyframe ? previous : values[k];
+		const unsigned int residual = bytes[i] | (bytes[n+i] << 8) | (bytes[2*n+i] << 16) | ((unsigned int)bytes[3*n+i] << 24);
+		const unsigned int value = block.array <= Z_ARRAY ? reference + (unsigned int)unzigzag(residual) : reference ^ residual;
+		previous = values[k] = value;
+		if(dataset == 0) continue;
+
+		Group& group = dataset->groups[block.group];
+		if(block.array <= Z_ARRAY) (&group.h_constraints[k].position.x)[block.array] = dequantize(value, header.grid_origin[block.array], header.grid_step[block.array]);
+		else std::memcpy(block.array == WEIGHT_ARRAY ? &group.h_constraints[k].weight : &group.h_radii[k], &value, sizeof(value));
+	}
+	return true;
+}
+
+static bool read_compressed_header(const MeshlessMapping* mapping, CompressedHeader& header)
+{
+	const unsigned char* file = static_cast<const unsigned char*>(mapping->address);
+	if(mapping->length < compressed_header_size || std::memcmp(file, compressed_magic, sizeof(compressed_magic)) != 0 || read_uint32(file+8) != compressed_version) return false;
+	const unsigned int n = read_uint32(file+12);
+	header.number_of_datasets = (int)n;
+	header.position_bits = (int)read_uint32(file+16);
+	header.keyframe_interval = (int)read_uint32(file+20);
+	for(int a = 0; a != 3; a++)
+	{
+		header.grid_origin[a] = read_double(file + 24 + 8*a);
+		header.grid_step[a] = read_double(file + 48 + 8*a);
+	}
+	const unsigned int error_bits = read_uint32(file+72);
+	std::memcpy(&header.position_error, &error_bits, sizeof(error_bits));
+	return n <= 0x7fffffff && header.position_bits >= 1 && header.position_bits <= 24 && compressed_header_size + 8ull*n <= mapping->length;
+}
+
+// the offset of timestep k's groups, or 0 if it isn't valid
+static unsigned long long compressed_timestep_offset(const MeshlessMapping* mapping, int k)
+{
+	const unsigned long long offset = read_uint64(static_cast<const unsigned char*>(mapping->address) + compressed_header_size + 8*k);
+	return offset >= compressed_header_size && offset <= mapping->length && mapping->length - offset >= 8 ? offset : 0;
+}
+
+static bool is_compressed_keyframe(const MeshlessMapping* mapping, int k)
+{
+	const unsigned long long offset = compressed_timestep_offset(mapping, k);
+	return offset != 0 && read_uint32(static_cast<const unsigned char*>(mapping->address) + offset + 4) != 0;
+}
+
+// Decodes timestep k, on top of the state of the timestep before it unless k is a keyframe, and into new arrays of dataset unless it
+// is 0.  Returns false, leaving no groups in dataset, if the timestep isn't valid.
+static bool decode_compressed_timestep(const MeshlessMapping* mapping, const CompressedHeader& header, int k, CompressedState& state, MeshlessDataset* dataset)
+{
+	const unsigned char* file = static_cast<const unsigned char*>(mapping->address);
+	const unsigned long long length = mapping->length;
+	const unsigned long long offset = compressed_timestep_offset(mapping, k);
+	if(dataset != 0)
+	{
+		dataset->number_of_groups = 0;
+		dataset->groups = 0;
+		dataset->generation = 0;
+		dataset->mapping = 0;
+	}
+	if(offset == 0) return false;
+
+	const unsigned long long number_of_groups = read_uint32(file+offset);
+	const bool keyframe = read_uint32(file+offset+4) != 0;
+	if(number_of_groups > 0x7fffffff || (length - offset - 8) / 16 < number_of_groups) return false;
+
+	std::vector<int> number_of_terms(number_of_groups);
+	std::vector<bool> has_radii(number_of_groups);
+	std::vector<unsigned int> basis_function_ids(number_of_groups);
+	for(unsigned long long j = 0; j != number_of_groups; j++)
+	{
+		const unsigned char* record = file + offset + 8 + 16*j;
+		const unsigned long long n = read_uint64(record);
+		basis_function_ids[j] = read_uint32(record+8);
+		has_radii[j] = read_uint32(record+12) != 0;
+		if(n > 0x7fffffff || basis_function_ids[j] > WENDLAND_D3_C2) return false;
+		number_of_terms[j] = (int)n;
+	}
+
+	if(keyframe) reset_compressed_state(state, number_of_terms, has_radii);
+	else
+	{
+		// differences only make sense on top of a timestep with the same groups
+		bool same_groups = state.size() == number_of_groups*NUMBER_OF_COMPRESSED_ARRAYS;
+		for(unsigned long long j = 0; j != number_of_groups && same_groups; j++)
+			same_groups = state[j*NUMBER_OF_COMPRESSED_ARRAYS].size() == (size_t)number_of_terms[j]
+				&& state[j*NUMBER_OF_COMPRESSED_ARRAYS + RADIUS_ARRAY].size() == (has_radii[j] ? (size_t)number_of_terms[j] : 0);
+		if(!same_groups) return false;
+	}
+
+	const std::vector<CompressedBlock> blocks = list_compressed_blocks(number_of_terms, has_radii);
+	const unsigned long long table = offset + 8 + 16*number_of_groups;
+	if((length - table) / 16 < blocks.size()) return false;
+
+	if(dataset != 0)
+	{
+		dataset->number_of_groups = (int)number_of_groups;
+		dataset->groups = new Group[number_of_groups];
+		std::memset(dataset->groups, 0, number_of_groups*sizeof(Group));
+		for(unsigned long long j = 0; j != number_of_groups; j++)
+		{
+			dataset->groups[j].number_of_terms = number_of_terms[j];
+			dataset->groups[j].basis_function_id = (BasisFunctionId)basis_function_ids[j];
+			dataset->groups[j].h_constraints = new Constraint[number_of_terms[j]];
+			dataset->groups[j].h_radii = has_radii[j] ? new float[number_of_terms[j]] : 0;
+		}
+	}
+
+	std::vector<char> decoded(blocks.size(), 0);
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	#pragma omp parallel for schedule(dynamic) num_threads(vis_get_number_of_threads())
+#else
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for(int b = 0; b < (int)blocks.size(); b++)
+	{
+		const unsigned long long block_offset = read_uint64(file + table + 16*b);
+		const unsigned long long block_size = read_uint64(file + table + 16*b + 8);
+		if(block_offset > length || length - block_offset < block_size) continue;
+		decoded[b] = decode_compressed_block(blocks[b], file + block_offset, file + block_offset + block_size, header, keyframe, state, dataset);
+	}
+
+	if(std::find(decoded.begin(), decoded.end(), 0) != decoded.end())
+	{
+		state.clear();
+		if(dataset != 0)
+		{
+			delete_meshless_dataset(*dataset);
+			dataset->number_of_groups = 0;
+			dataset->groups = 0;
+		}
+		return false;
+	}
+	return true;
+}
+
+bool is_compressed_meshless_file(const char* filename)
+{
+	return file_starts_with(filename, compressed_magic);
+}
+
+bool load_meshless_datasets_from_compressed_file(const char* filename, MeshlessDataset** meshless_datasets, int* number_of_datasets)
+{
+	*meshless_datasets = 0;
+	*number_of_datasets = 0;
+
+	MeshlessMapping* mapping = map_file(filename);
+	if(mapping == 0) return false;
+	CompressedHeader header;
+	if(!read_compressed_header(mapping, header))
+	{
+		unmap_file(mapping);
+		return false;
+	}
+
+	// each timestep but the keyframes is decoded on top of the one before
+	const int n = header.number_of_datasets;
+	MeshlessDataset* datasets = n != 0 ? new MeshlessDataset[n] : 0;
+	CompressedState state;
+	for(int i = 0; i != n; i++)
+	{
+		if(!decode_compressed_timestep(mapping, header, i, state, &datasets[i]))
+		{
+			delete_meshless_datasets(datasets, i);
+			unmap_file(mapping);
+			return false;
+		}
+	}
+	unmap_file(mapping);
+
+	*meshless_datasets = datasets;
+	*number_of_datasets = n;
+	return true;
+}
+
+bool save_meshless_datasets_to_compressed_file(const char* filename, MeshlessDataset* meshless_datasets, int number_of_datasets, int position_bits, int keyframe_interval, float* position_error)
+{
+	if(position_bits < 1 || position_bits > 24 || keyframe_interval < 1) return false;
+	std::ofstream file(filename, std::ios::binary);
+	if(!file) return false;
+
+	// the grid spans the bounding box of every position of every timestep
+	CompressedHeader header;
+	header.number_of_datasets = number_of_datasets;
+	header.position_bits = position_bits;
+	header.keyframe_interval = keyframe_interval;
+	float minimum[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, maximum[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for(int i = 0; i != number_of_datasets; i++)
+		for(int j = 0; j != meshless_datasets[i].number_of_groups; j++)
+			for(int k = 0; k != meshless_datasets[i].groups[j].number_of_terms; k++)
+				for(int a = 0; a != 3; a++)
+				{
+					const float x = (&meshless_datasets[i].groups[j].h_constraints[k].position.x)[a];
+					minimum[a] = std::min(minimum[a], x);
+					maximum[a] = std::max(maximum[a], x);
+				}
+	for(int a = 0; a != 3; a++)
+	{
+		header.grid_origin[a] = minimum[a] <= maximum[a] ? minimum[a] : 0.0;
+		header.grid_step[a] = minimum[a] < maximum[a] ? ((double)maximum[a] - minimum[a]) / ((1u << position_bits) - 1) : 0.0;
+	}
+	header.position_error = 0.0f;
+
+	std::vector<unsigned char> header_bytes(compressed_header_size + 8*(size_t)number_of_datasets, 0);
+	file.write(reinterpret_cast<const char*>(&header_bytes[0]), header_bytes.size());
+	unsigned long long offset = header_bytes.size();
+
+	CompressedState state;
+	std::vector<int> previous_number_of_terms;
+	std::vector<bool> previous_has_radii;
+	for(int i = 0; i != number_of_datasets; i++)
+	{
+		const MeshlessDataset& dataset = meshless_datasets[i];
+		std::vector<int> number_of_terms(dataset.number_of_groups);
+		std::vector<bool> has_radii(dataset.number_of_groups);
+		for(int j = 0; j != dataset.number_of_groups; j++)
+		{
+			number_of_terms[j] = dataset.groups[j].number_of_terms;
+			has_radii[j] = dataset.groups[j].h_radii != 0;
+		}
+		const bool keyframe = i % keyframe_interval == 0 || number_of_terms != previous_number_of_terms || has_radii != previous_has_radii;
+		if(keyframe) reset_compressed_state(state, number_of_terms, has_radii);
+		previous_number_of_terms = number_of_terms;
+		previous_has_radii = has_radii;
+
+		const std::vector<CompressedBlock> blocks = list_compressed_blocks(number_of_terms, has_radii);
+		std::vector<std::vector<unsigned char> > coded(blocks.size());
+		std::vector<float> errors(blocks.size());
+#ifdef _LIBMESHLESSVIS_USE_CPU
+		#pragma omp parallel for schedule(dynamic) num_threads(vis_get_number_of_threads())
+#else
+		#pragma omp parallel for schedule(dynamic)
+#endif
+		for(int b = 0; b < (int)blocks.size(); b++) errors[b] = encode_compressed_block(blocks[b], dataset, header, keyframe, state, coded[b]);
+		for(int b = 0; b != (int)blocks.size(); b++) header.position_error = std::max(header.position_error, errors[b]);
+
+		std::vector<unsigned char> timestep(8 + 16*(size_t)dataset.number_of_groups + 16*blocks.size());
+		write_uint32(&timestep[0], dataset.number_of_groups);
+		write_uint32(&timestep[4], keyframe);
+		for(int j = 0; j != dataset.number_of_groups; j++)
+		{
+			write_uint64(&timestep[8 + 16*j], number_of_terms[j]);
+			write_uint32(&timestep[8 + 16*j + 8], dataset.groups[j].basis_function_id);
+			write_uint32(&timestep[8 + 16*j + 12], has_radii[j]);
+		}
+		write_uint64(&header_bytes[compressed_header_size + 8*i], offset);
+		offset += timestep.size();
+		for(int b = 0; b != (int)blocks.size(); b++)
+		{
+			unsigned char* entry = &timestep[8 + 16*dataset.number_of_groups + 16*b];
+			write_uint64(entry, offset);
+			write_uint64(entry+8, coded[b].size());
+			offset += coded[b].size();
+		}
+		file.write(reinterpret_cast<const char*>(&timestep[0]), timestep.size());
+		for(int b = 0; b != (int)blocks.size(); b++) if(!coded[b].empty()) file.write(reinterpret_cast<const char*>(&coded[b][0]), coded[b].size());
+	}
+
+	std::memcpy(&header_bytes[0], compressed_magic, sizeof(compressed_magic));
+	write_uint32(&header_bytes[8], compressed_version);
+	write_uint32(&header_bytes[12], number_of_datasets);
+	write_uint32(&header_bytes[16], position_bits);
+	write_uint32(&header_bytes[20], keyframe_interval);
+	for(int a = 0; a != 3; a++)
+	{
+		write_double(&header_bytes[24 + 8*a], header.grid_origin[a]);
+		write_double(&header_bytes[48 + 8*a], header.grid_step[a]);
+	}
+	unsigned int error_bits;
+	std::memcpy(&error_bits, &header.position_error, sizeof(error_bits));
+	write_uint32(&header_bytes[72], error_bits);
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header_bytes[0]), header_bytes.size());
+
+	if(position_error != 0) *position_error = header.position_error;
+	return (bool)file;
+}
+
+enum MeshlessFileFormat
+{
+	TEXT_FILE,
+	BINARY_FILE,
+	COMPRESSED_FILE
+};
+
+struct MeshlessDatasetReader
+{
+	MeshlessMapping* mapping;
+	MeshlessFileFormat format;
+
+	// where each timestep starts, as the index of its first token for text files
+	int number_of_datasets;
+	TextTokens* tokens;
+	std::vector<long long> first_tokens;
+
+	// for compressed files, the state after decoding timestep state_index, so that the timesteps after it are decoded on top of it
+	CompressedHeader compressed_header;
+	CompressedState state;
+	int state_index;
+
+	// the timestep loaded, -1 if none is
+	int current;
+	MeshlessDataset dataset;
+};
+
+// every timestep a reader loads gets a generation of its own, so that registrations cached for one are never taken for another that
+// happens to reuse its memory
+static int next_reader_generation()
+{
+	static int generation = 0;
+	int next;
+	#pragma omp critical(meshless_reader_generation)
+	next = ++generation;
+	return next;
+}
+
+static void unload_current_dataset(MeshlessDatasetReader* reader)
+{
+	if(reader->current < 0) return;
+	delete_meshless_dataset(reader->dataset);
+	reader->current = -1;
+}
+
+MeshlessDatasetReader* meshless_dataset_reader_open(const char* filename)
+{
+	MeshlessMapping* mapping = map_file(filename);
+	if(mapping == 0) return 0;
+
+	MeshlessDatasetReader* reader = new MeshlessDatasetReader;
+	reader->mapping = mapping;
+	reader->format = binary_number_of_datasets(mapping) >= 0 ? BINARY_FILE : read_compressed_header(mapping, reader->compressed_header) ? COMPRESSED_FILE : TEXT_FILE;
+	reader->tokens = 0;
+	reader->state_index = -1;
+	reader->current = -1;
+	if(reader->format == BINARY_FILE) reader->number_of_datasets = binary_number_of_datasets(mapping);
+	else if(reader->format == COMPRESSED_FILE) reader->number_of_datasets = reader->compressed_header.number_of_datasets;
+	else
+	{
+		const char* file = static_cast<const char*>(mapping->address);
+		reader->tokens = new TextTokens(file, file + mapping->length);
+
+		long long token = 0;
+		const char* p = reader->tokens->find(token);
+		reader->number_of_datasets = std::max(0, next_integer(p, reader->tokens->end(), token));
+		reader->first_tokens.resize(reader->number_of_datasets);
+		for(int i = 0; i != reader->number_of_datasets; i++)
+		{
+			reader->first_tokens[i] = token;
+			skip_text_dataset(*reader->tokens, token);
+		}
+	}
+	return reader;
+}
+
+void meshless_dataset_reader_close(MeshlessDatasetReader* reader)
+{
+	if(reader == 0) return;
+	unload_current_dataset(reader);
+	delete reader->tokens;
+	unmap_file(reader->mapping);
+	delete reader;
+}
+
+int meshless_dataset_reader_get_number_of_datasets(MeshlessDatasetReader* reader)
+{
+	return reader->number_of_datasets;
+}
+
+int meshless_dataset_reader_get_index(MeshlessDatasetReader* reader)
+{
+	return reader->current;
+}
+
+MeshlessDataset* meshless_dataset_reader_seek(MeshlessDatasetReader* reader, int k)
+{
+	if(k >= 0 && k == reader->current) return &reader->dataset;
+	unload_current_dataset(reader);
+	if(k < 0 || k >= reader->number_of_datasets) return 0;
+
+	MeshlessDataset& dataset = reader->dataset;
+	if(reader->format == BINARY_FILE)
+	{
+		// the arrays are copied out of the mapping, which would otherwise keep a private copy of every page a shift wrote to
+		MeshlessDataset mapped;
+		if(!map_binary_dataset(reader->mapping, k, mapped)) return 0;
+		dataset.number_of_groups = mapped.number_of_groups;
+		dataset.groups = mapped.groups;
+		dataset.mapping = 0;
+		for(int j = 0; j != dataset.number_of_groups; j++)
+		{
+			Group& group = dataset.groups[j];
+			const Constraint* h_constraints = group.h_constraints;
+			group.h_constraints = new Constraint[group.number_of_terms];
+			std::copy(h_constraints, h_constraints + group.number_of_terms, group.h_constraints);
+			if(group.h_radii != 0)
+			{
+				const float* h_radii = group.h_radii;
+				group.h_radii = new float[group.number_of_terms];
+				std::copy(h_radii, h_radii + group.number_of_terms, group.h_radii);
+			}
+			if(!host_is_little_endian()) swap_group_bytes(group);
+		}
+	}
+	else if(reader->format == COMPRESSED_FILE)
+	{
+		// decode from the keyframe timestep k depends on, or from the timestep decoded last if that comes after it
+		int first = k;
+		while(first > 0 && !is_compressed_keyframe(reader->mapping, first)) first--;
+		if(reader->state_index >= first && reader->state_index < k) first = reader->state_index + 1;
+		reader->state_index = -1;
+		for(int i = first; i < k; i++) if(!decode_compressed_timestep(reader->mapping, reader->compressed_header, i, reader->state, 0)) return 0;
+		if(!decode_compressed_timestep(reader->mapping, reader->compressed_header, k, reader->state, &dataset)) return 0;
+		reader->state_index = k;
+	}
+	else
+	{
+		long long token = reader->first_tokens[k];
+		load_text_dataset(*reader->tokens, token, dataset);
+	}
+	dataset.generation = next_reader_generation();
+	reader->current = k;
+	return &dataset;
+}
+
+MeshlessDataset* meshless_dataset_reader_next(MeshlessDatasetReader* reader)
+{
+	return meshless_dataset_reader_seek(reader, reader->current + 1);
+}
+
+float meshless_dataset_reader_get_position_error(MeshlessDatasetReader* reader)
+{
+	return reader->format == COMPRESSED_FILE ? reader->compressed_header.position_error : 0.0f;
+}
@@ -36,94 +36,106 @@ __device__ __host__ float dot(float3 a, float3 b)
 	return a.x*b.x + a.y*b.y + a.z*b.z;
 }
 
-__device__ __host__ unsigned int point_in_box(float2 point, float4 bounding_box)
-{
-	return (point.x >= bounding_box.x && point.y >= bounding_box.y && point.x <= bounding_box.z && point.y <= bounding_box.w);
-}
-
-__global__ void compute_mask(Group group, unsigned int* mask, float4 bounding_box, float3 u_axis, float3 v_axis)
+// A term whose footprint, its projection onto the image plane give or take its radius, lies entirely outside the period of the image
+// centered on the origin only shows up as an alias of itself, as in the CPU backend.  SPH's and the gaussian's are twice their radius.
+__global__ void compute_mask(Group group, unsigned int* mask, float2 half_size, float3 u_axis, float3 v_axis)
 {
 	int index = (blockDim.x*blockIdx.x + threadIdx.x);
+	if(index >= group.number_of_terms)
+	{
+		mask[index] = 0;
+		return;
+	}
 	float3 center = group.d_constraints[index].position;
-	float radius = group.d_radii[index];
-	
-	float2 icenter = make_float2(dot(center, u_axis),dot(center, v_axis));
-
-	float2 corner1 = make_float2(icenter.x+radius, icenter.y+radius);
-	float2 corner2 = make_float2(icenter.x+radius, icenter.y-radius);
-	float2 corner3 = make_float2(icenter.x-radius, icenter.y-radius);
-	float2 corner4 = make_float2(icenter.x-radius, icenter.y+radius);	
-	
-	mask[index] = index < group.number_of_terms && (point_in_box(corner1, bounding_box) && point_in_box(corner2, bounding_box) && point_in_box(corner3, bounding_box) && point_in_box(corner4, bounding_box));
+	float radius = group.d_radii ? group.d_radii[index] : 1.0f;
+	if(group.basis_function_id != WENDLAND_D3_C2) radius *= 2.0f;
+	float u = dot(center, u_axis), v = dot(center, v_axis);
+	mask[index] = fabsf(u) - radius <= half_size.x && fabsf(v) - radius <= half_size.y;
 }
 
+// scatters the masked terms to the positions given by the exclusive scan of the mask
 template<typename T>
 __global__ void compact(T* in, T* out, unsigned int* mask, unsigned int* indices)
 {
 	int index = (blockDim.x*blockIdx.x + threadIdx.x);
-	if(mask[index]) out[index] = in[indices[index]];
+	if(mask[index]) out[indices[index]] = in[index];
 }
 
-void cull_fully_aliased_terms(MeshlessDataset* meshless_dataset, VisConfig* vis_config)
+// copies the group's terms that aren't fully aliased into new zero padded arrays, keeping their order, the registered arrays are left
+// alone so the next view still has every term.  mask and indices hold at least group.d_number_of_terms.
+Group cull_fully_aliased_terms(const Group& group, VisConfig* vis_config, CUDPPScanConfig* scan_config, unsigned int* mask, unsigned int* indices)
 {
-	int max_number_of_terms = meshless_dataset->groups[0].d_number_of_terms;
-	for(int k = 1; k < meshless_dataset->number_of_groups; k++) { if(max_number_of_terms < meshless_dataset->groups[k].number_of_terms) max_number_of_terms = meshless_dataset->groups[k].d_number_of_terms; }
-	
+	Group culled = group;
+	int padding = vis_config->_number_of_partial_sums*vis_config->block_length;
+	culled.number_of_terms = 0;
+	if(group.number_of_terms > 0)
+	{
+		dim3 block_size(vis_config->block_length);
+		dim3 grid(group.d_number_of_terms / vis_config->block_length);
+		float2 half_size = make_float2(0.5f/vis_config->step_size.x, 0.5f/vis_config->step_size.y);
+		compute_mask<<<grid, block_size>>>(group, mask, half_size, vis_config->u_axis, vis_config->v_axis); CUT_CHECK_ERROR("compute_mask failed");
+		cudppScan(indices, mask, group.d_number_of_terms, scan_config);
+
+		unsigned int last_index, last_mask;
+		CUDA_SAFE_CALL(cudaMemcpy(&last_index, indices + group.d_number_of_terms-1, sizeof(unsigned int), cudaMemcpyDeviceToHost));
+		CUDA_SAFE_CALL(cudaMemcpy(&last_mask, mask + group.d_number_of_terms-1, sizeof(unsigned int), cudaMemcpyDeviceToHost));
+		culled.number_of_terms = (int)(last_index + last_mask);
+	}
+	culled.d_number_of_terms = padding*max(1, (culled.number_of_terms + padding-1)/padding);
+
+	CUDA_SAFE_CALL(cudaMalloc((void**)&culled.d_constraints, sizeof(Constraint)*culled.d_number_of_terms));
+	CUDA_SAFE_CALL(cudaMemset((void*)culled.d_constraints, 0, sizeof(Constraint)*culled.d_number_of_terms));
+	if(group.d_radii)
+	{
+		CUDA_SAFE_CALL(cudaMalloc((void**)&culled.d_radii, sizeof(float)*culled.d_number_of_terms));
+		CUDA_SAFE_CALL(cudaMemset((void*)culled.d_radii, 0, sizeof(float)*culled.d_number_of_terms));
+	}
+	if(culled.number_of_terms > 0)
+	{
+		dim3 block_size(vis_config->block_length);
+		dim3 grid(group.d_number_of_terms / vis_config->block_length);
+		compact<<<grid, block_size>>>(group.d_constraints, culled.d_constraints, mask, indices);
+		if(group.d_radii) compact<<<grid, block_size>>>(group.d_radii, culled.d_radii, mask, indices);
+		CUT_CHECK_ERROR("compact failed");
+	}
+	return culled;
+}
+
+void fourier_transform_culled(MeshlessDataset* meshless_dataset, VisConfig* vis_config)
+{
+	int max_number_of_terms = 1;
+	for(int k = 0; k < meshless_dataset->number_of_groups; k++) max_number_of_terms = max(max_number_of_terms, meshless_dataset->groups[k].d_number_of_terms);
+
 	unsigned int* mask, *indices;
 	CUDA_SAFE_CALL(cudaMalloc((void**)&mask, sizeof(unsigned int)*max_number_of_terms));
 	CUDA_SAFE_CALL(cudaMalloc((void**)&indices, sizeof(unsigned int)*max_number_of_terms));
 
-	unsigned int* cpu_mask1 = (unsigned int*)malloc(sizeof(unsigned int)*max_number_of_terms);
-	unsigned int* cpu_mask2 = (unsigned int*)malloc(sizeof(unsigned int)*max_number_of_terms);
-
-	Constraint* compacted_constraints; float* compacted_radii;
-	CUDA_SAFE_CALL(cudaMalloc((void**)&compacted_constraints, sizeof(Constraint)*max_number_of_terms));
-	CUDA_SAFE_CALL(cudaMalloc((void**)&compacted_radii, sizeof(float)*max_number_of_terms));
-
-	CUDPPScanConfig config;
-    config.direction = CUDPP_SCAN_FORWARD;
-    config.exclusivity = CUDPP_SCAN_EXCLUSIVE;
-    config.maxNumElements = max_number_of_terms;
-    config.maxNumRows = 1;
-    config.datatype = CUDPP_UINT;
-    config.op = CUDPP_ADD;
-    
-    cudppInitializeScan(&config);
-
-	dim3 block_length(vis_config->block_length);
-	float w = 1.0f/vis_config->step_size.x, h = 1.0f/vis_config->step_size.y;
-	float4 bounding_box = make_float4(0, 0, w/2, h/2);
-	for(int k = 0; k < meshless_dataset->number_of_groups; k++)
-	{
-		Group group = meshless_dataset->groups[k];
-
-		// Step 1: Compute the mask
-		dim3 grid(group.d_number_of_terms / vis_config->block_length); if(group.d_number_of_terms%vis_config->block_length > 0) printf("error\n");
-		compute_mask<<<grid, block_length>>>(group, mask, bounding_box, vis_config->u_axis, vis_config->v_axis);
-		
-		// Step 2: Compute the indices
-		cudppScan(indices, mask, group.number_of_terms, &config);
-		
-		// Step 3: Map data
-		CUDA_SAFE_CALL(cudaMemset(compacted_radii, 0, group.d_number_of_terms*sizeof(float)));
-		compact<<<grid, block_length>>>(group.d_radii, compacted_radii, mask, indices);
-		CUDA_SAFE_CALL(cudaMemcpy(group.d_constraints, compacted_constraints, group.d_number_of_terms*sizeof(float), cudaMemcpyDeviceToDevice));
-
-		CUDA_SAFE_CALL(cudaMemset(compacted_constraints, 0, group.d_number_of_terms*sizeof(Constraint)));
-		compact<<<grid, block_length>>>(group.d_constraints, compacted_constraints, mask, indices);
-		CUDA_SAFE_CALL(cudaMemcpy(group.d_constraints, compacted_constraints, group.d_number_of_terms*sizeof(Constraint), cudaMemcpyDeviceToDevice));
-	}
+	CUDPPScanConfig scan_config;
+	scan_config.direction = CUDPP_SCAN_FORWARD;
+	scan_config.exclusivity = CUDPP_SCAN_EXCLUSIVE;
+	scan_config.maxNumElements = max_number_of_terms;
+	scan_config.maxNumRows = 1;
+	scan_config.datatype = CUDPP_UINT;
+	scan_config.op = CUDPP_ADD;
+	cudppInitializeScan(&scan_config);
 
-	cudppFinalizeScan(&config);
-	
-	free(cpu_mask1);
-	free(cpu_mask2);
-		
+	Group* culled_groups = new Group[max(1, meshless_dataset->number_of_groups)];
+	for(int k = 0; k < meshless_dataset->number_of_groups; k++) culled_groups[k] = cull_fully_aliased_terms(meshless_dataset->groups[k], vis_config, &scan_config, mask, indices);
+
+	cudppFinalizeScan(&scan_config);
 	CUDA_SAFE_CALL(cudaFree(mask));
 	CUDA_SAFE_CALL(cudaFree(indices));
-	CUDA_SAFE_CALL(cudaFree(compacted_constraints));
-	CUDA_SAFE_CALL(cudaFree(compacted_radii));
 
+	MeshlessDataset culled_dataset = *meshless_dataset;
+	culled_dataset.groups = culled_groups;
+	fourier_transform(&culled_dataset, vis_config);
+
+	for(int k = 0; k < meshless_dataset->number_of_groups; k++)
+	{
+		CUDA_SAFE_CALL(cudaFree(culled_groups[k].d_constraints));
+		if(culled_groups[k].d_radii) CUDA_SAFE_CALL(cudaFree(culled_groups[k].d_radii));
+	}
+	delete[] culled_groups;
 }
 
 VisConfig* vis_config_create(bool automatic_d_image, float2 step_size, int2 cutoff_frequency, float3 u_axis, float3 v_axis, int2 number_of_samples, int block_length, int number_of_partial_sums)
@@ -298,6 +310,67 @@ void vis_unregister_meshless_dataset(VisConfig* vis_config, MeshlessDataset* mes
 	}
 }
 
+// A registration registers a copy of the dataset's groups, remembering what their terms were padded to
+struct VisRegistration
+{
+	MeshlessDataset meshless_dataset;
+	int padding;
+	int references;
+};
+
+VisRegistration* vis_registration_create(VisConfig* vis_config, MeshlessDataset* meshless_dataset)
+{
+	VisRegistration* registration = new VisRegistration;
+	registration->meshless_dataset = *meshless_dataset;
+	registration->meshless_dataset.groups = new Group[max(1, meshless_dataset->number_of_groups)];
+	for(int j = 0; j != meshless_dataset->number_of_groups; j++) registration->meshless_dataset.groups[j] = meshless_dataset->groups[j];
+	registration->padding = vis_config->_number_of_partial_sums*vis_config->block_length;
+	registration->references = 1;
+	vis_register_meshless_dataset(vis_config, &registration->meshless_dataset);
+	return registration;
+}
+
+void vis_registration_retain(VisRegistration* registration)
+{
+	registration->references++;
+}
+
+void vis_registration_release(VisRegistration* registration)
+{
+	if(registration == 0 || --registration->references > 0) return;
+	vis_unregister_meshless_dataset(0, &registration->meshless_dataset);
+	delete[] registration->meshless_dataset.groups;
+	delete registration;
+}
+
+// the kernels run one block of block_length threads per block_length terms, for each partial sum
+bool vis_registration_is_compatible(VisRegistration* registration, VisConfig* vis_config)
+{
+	int padding = vis_config->_number_of_partial_sums*vis_config->block_length;
+	return padding > 0 && registration->padding % padding == 0;
+}
+
+size_t vis_registration_size(VisRegistration* registration)
+{
+	size_t size = 0;
+	for(int j = 0; j != registration->meshless_dataset.number_of_groups; j++)
+	{
+		const Group& group = registration->meshless_dataset.groups[j];
+		size += group.d_number_of_terms*(sizeof(Constraint) + (group.d_radii ? sizeof(float) : 0));
+	}
+	return size;
+}
+
+void vis_registration_fourier_volume_rendering(VisRegistration* registration, VisConfig* vis_config)
+{
+	vis_fourier_volume_rendering(&registration->meshless_dataset, vis_config);
+}
+
+void vis_registration_opengl_fourier_volume_rendering(VisRegistration* registration, VisConfig* vis_config, GLuint buffer_object)
+{
+	vis_opengl_fourier_volume_rendering(&registration->meshless_dataset, vis_config, buffer_object);
+}
+
 __global__ void reduce_partial_sums(VisConfig vis_config)
 {
 	// TODO: replace this kernel with a call to cudppMultiScan (if possible)
@@ -333,10 +406,10 @@ __global__ void arrange_samples(VisConfig vis_config)
 
 void vis_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config)
 {
-//	cull_fully_aliased_terms(meshless_dataset, vis_config);
-	
 	CUDA_SAFE_CALL(cudaMemset((void*)vis_config->_d_freq_image_arranged, 0, sizeof(float2)*vis_config->_number_of_samples.x*(vis_config->_number_of_samples.y/2+1)));
-	fourier_transform(meshless_dataset, vis_config); CUT_CHECK_ERROR("fourier_transform failed");
+	if(vis_config->cull_fully_aliased_terms) fourier_transform_culled(meshless_dataset, vis_config);
+	else                                     fourier_transform(meshless_dataset, vis_config);
+	CUT_CHECK_ERROR("fourier_transform failed");
 
 	dim3 block_size(vis_config->block_length);
 	dim3 cutoff_grid(2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y / vis_config->block_length);	
@@ -19,49 +19,114 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "meshless_vis.h"
 
+#include <omp.h>
+
 #ifdef WIN32
-#include <omp.h>	//necessary for me to compile using visual studio
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sched.h>
 #endif
 
 #include <iostream>
 #include <cstdlib>
-#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
 #include <GL/glew.h>
 #include <fftw3.h>
 
 #include "fourier_transform.h"
+#include "fourier_transform_simd_cpu.h"
+#include "fourier_transform_spectrum_cpu.h"
+#include "fourier_transform_tree_cpu.h"
+#include "fourier_transform_tables_cpu.h"
+#include "fft_plans_cpu.h"
+#include "memory_cpu.h"
 
 inline void complex_assign(fftwf_complex& l, const fftwf_complex& r) { l[0] = r[0], l[1] = r[1]; }
 inline void complex_accumulate(fftwf_complex& l, const fftwf_complex& r) { l[0] += r[0], l[1] += r[1]; }
 
+// Only the first _cutoff_frequency.y columns of _d_freq_image_arranged are ever nonzero, and only 2*_cutoff_frequency.x-1 rows
+// of those, so instead of a dense 2D C2R the inverse FFT runs the length _number_of_samples.x transforms down just those columns,
+// in place, followed by a length _number_of_samples.y C2R along every row (see fft_plans_cpu.h).  The row transforms preserve
+// their input, so the columns past the cutoff stay zero and only the rows that arrange_samples doesn't write need clearing between
+// frames.  This clears the lot, for a new array or when the column transforms may have written further out than they will now.
+// It goes row by row in the same static partition as the row transforms, so that with _parallel_first_touch each row's pages
+// start out on the node of the thread that transforms it.
+void clear_arranged_samples(VisConfig* vis_config)
+{
+	int row_length = vis_config->_number_of_samples.y/2+1, x;
+	#pragma omp parallel for schedule(static) num_threads(vis_get_number_of_threads()) if(vis_config->_parallel_first_touch)
+	for(x = 0; x < vis_config->_number_of_samples.x; x++)
+	{
+		memset((void*)(vis_config->_d_freq_image_arranged + x*row_length), 0, sizeof(fftwf_complex)*row_length);
+	}
+}
+
+// first touches the image the way the row transforms write it
+void clear_image(VisConfig* vis_config)
+{
+	int x;
+	#pragma omp parallel for schedule(static) num_threads(vis_get_number_of_threads()) if(vis_config->_parallel_first_touch)
+	for(x = 0; x < vis_config->_number_of_samples.x; x++)
+	{
+		memset((void*)(vis_config->_d_image + x*vis_config->_number_of_samples.y), 0, sizeof(float)*vis_config->_number_of_samples.y);
+	}
+}
+
+void allocate_images(VisConfig* vis_config)
+{
+	vis_config->_d_freq_image_arranged = (fftwf_complex*)memory_allocate(sizeof(fftwf_complex)*vis_config->_number_of_samples.x*(vis_config->_number_of_samples.y/2+1), vis_config->_huge_pages);
+	clear_arranged_samples(vis_config);
+	if(vis_config->_automatic_d_image)
+	{
+		vis_config->_d_image = (float*)memory_allocate(sizeof(float)*vis_config->_number_of_samples.x*vis_config->_number_of_samples.y, vis_config->_huge_pages);
+		clear_image(vis_config);
+	}
+}
+
+void free_images(VisConfig* vis_config)
+{
+	if(vis_config->_automatic_d_image) memory_free(vis_config->_d_image);
+	memory_free(vis_config->_d_freq_image_arranged);
+}
+
 VisConfig* vis_config_create(bool automatic_d_image, float2 step_size, int2 cutoff_frequency, float3 u_axis, float3 v_axis, int2 number_of_samples, int block_length, int number_of_partial_sums)
 {
+	fft_threads_acquire();
 	VisConfig* vis_config = new VisConfig;
 	vis_config->step_size = step_size;
 	vis_config->u_axis = u_axis;
 	vis_config->v_axis = v_axis;
 	vis_config->cull_fully_aliased_terms = false;
+	vis_config->instruction_set = vis_get_supported_instruction_set();
+	vis_config->sampling_method = VIS_DIRECT_SUMMATION;
+	vis_config->nufft_tolerance = 1.0e-5f;
+	vis_config->basis_function_tolerance = 0.0f;
+	for(int i = 0; i < 3; i++) vis_config->_basis_function_tables[i] = 0;
+	vis_config->tile_samples = 256;
+	vis_config->tile_terms = 1024;
+	vis_config->fuse_groups = true;
+	vis_config->basis_function_epsilon = 0.0f;
+	for(int i = 0; i < 3; i++) vis_config->_negligible_argument[i] = 0.0f;
 	vis_config->_number_of_samples = number_of_samples;
 	vis_config->_cutoff_frequency = cutoff_frequency;
 	vis_config->block_length = block_length;
-	vis_config->_number_of_partial_sums = 1; // until there are on the order of 128 cores in CPUs this optimization is pointless
+	vis_config->_number_of_partial_sums = number_of_partial_sums;
 
-	vis_config->_d_freq_image = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y*vis_config->_number_of_partial_sums);
-	vis_config->_d_freq_image_arranged = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*vis_config->_number_of_samples.x*(vis_config->_number_of_samples.y/2+1));
+	vis_config->_parallel_first_touch = false;
+	vis_config->replicate_terms = false;
+	vis_config->_huge_pages = VIS_HUGE_PAGES_NONE;
 
+	vis_config->_arrange_samples_in_kernels = true;
+	vis_config->_d_freq_image = 0;
 	vis_config->_automatic_d_image = true; // the CPU code only works this way
-	if(vis_config->_automatic_d_image) vis_config->_d_image = (float*)fftwf_malloc(sizeof(float)*vis_config->_number_of_samples.x*vis_config->_number_of_samples.y);
+	allocate_images(vis_config);
 
-	char* str_num_threads = getenv ("OMP_NUM_THREADS");
-	int num_threads = 1;
-	if(str_num_threads != 0)
-	{
-		std::stringstream(std::string(str_num_threads)) >> num_threads;
-		std::cout << "Using " << num_threads << " threads" << std::endl;
-	}
-	fftwf_init_threads();
-	fftwf_plan_with_nthreads(num_threads);
-	vis_config->_plan = fftwf_plan_dft_c2r_2d(vis_config->_number_of_samples.x, vis_config->_number_of_samples.y, vis_config->_d_freq_image_arranged, vis_config->_d_image, FFTW_ESTIMATE);
+	vis_config->fft_planning = VIS_FFT_ESTIMATE;
+	update_basis_function_tables(vis_config, 0);
 	
 	return vis_config;
 }
@@ -74,7 +139,7 @@ VisConfig* vis_config_get_default()
 	float3 v_axis = make_float3(0.0f, 1.0f, 0.0f);
 	int2 number_of_samples = make_int2(512,512);
 	int block_length = 256;
-	int number_of_partial_sums = 1;
+	int number_of_partial_sums = 0;
 	VisConfig* vis_config = vis_config_create(true, step_size, cutoff_frequency, u_axis, v_axis, number_of_samples, block_length, number_of_partial_sums);
 	return vis_config;
 }
@@ -84,7 +149,8 @@ bool vis_config_check(VisConfig* vis_config)
 
 	if(2*vis_config->_cutoff_frequency.x > vis_config->_number_of_samples.x) return false;
 	if(2*vis_config->_cutoff_frequency.y > vis_config->_number_of_samples.y) return false;
-	if(vis_config->_number_of_partial_sums != 1) return false;
+	if(vis_config->_number_of_partial_sums < 0) return false;
+	if(vis_config->tile_samples < 1 || vis_config->tile_terms < 1) return false;
 
 	return true;
 }
@@ -96,44 +162,58 @@ void vis_config_manual_d_image(VisConfig* vis_config, float* d_image)
 
 void vis_config_change_number_of_samples(VisConfig* vis_config, int2 number_of_samples)
 {
+	free_images(vis_config);
 	vis_config->_number_of_samples = number_of_samples;
+	allocate_images(vis_config);
+}
 
-	if(vis_config->_automatic_d_image)
+// _d_freq_image is only needed when arrange_samples copies the samples into _d_freq_image_arranged
+void reallocate_freq_image(VisConfig* vis_config)
+{
+	memory_free(vis_config->_d_freq_image);
+	vis_config->_d_freq_image = 0;
+	if(!vis_config->_arrange_samples_in_kernels)
 	{
-		fftwf_free(vis_config->_d_image);
-		vis_config->_d_image = (float*)fftwf_malloc(sizeof(float)*vis_config->_number_of_samples.x*vis_config->_number_of_samples.y);
+		vis_config->_d_freq_image = (fftwf_complex*)memory_allocate(sizeof(fftwf_complex)*2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y, vis_config->_huge_pages);
 	}
-	
-	fftwf_free(vis_config->_d_freq_image_arranged);
-	vis_config->_d_freq_image_arranged = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*vis_config->_number_of_samples.x*(vis_config->_number_of_samples.y/2+1));
-	
-	fftwf_destroy_plan(vis_config->_plan);
-	vis_config->_plan = fftwf_plan_dft_c2r_2d(vis_config->_number_of_samples.x, vis_config->_number_of_samples.y, vis_config->_d_freq_image_arranged, vis_config->_d_image, FFTW_ESTIMATE);
+}
+
+void vis_config_arrange_samples_in_kernels(VisConfig* vis_config, bool arrange_samples_in_kernels)
+{
+	vis_config->_arrange_samples_in_kernels = arrange_samples_in_kernels;
+	reallocate_freq_image(vis_config);
+}
+
+void vis_config_place_memory(VisConfig* vis_config, bool parallel_first_touch, VisHugePages huge_pages)
+{
+	free_images(vis_config);
+	vis_config->_parallel_first_touch = parallel_first_touch;
+	vis_config->_huge_pages = huge_pages;
+	allocate_images(vis_config);
+	reallocate_freq_image(vis_config);
 }
 
 void vis_config_change_cutoff_frequency(VisConfig* vis_config, int2 cutoff_frequency)
 {
 	vis_config->_cutoff_frequency = cutoff_frequency;
-	fftwf_free(vis_config->_d_freq_image);
-	vis_config->_d_freq_image = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y*vis_config->_number_of_partial_sums);
+	reallocate_freq_image(vis_config);
+
+	// the old column transforms may have covered more columns
+	clear_arranged_samples(vis_config);
 }
 
 void vis_config_change_number_of_partial_sums(VisConfig* vis_config, int number_of_partial_sums)
 {
 	vis_config->_number_of_partial_sums = number_of_partial_sums;
-
-	fftwf_free(vis_config->_d_freq_image);
-	vis_config->_d_freq_image = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex)*2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y*vis_config->_number_of_partial_sums);
 }
 
 void vis_config_destroy(VisConfig* vis_config)
 {
-	if(vis_config->_automatic_d_image) fftwf_free(vis_config->_d_image);
-	fftwf_free(vis_config->_d_freq_image_arranged);
-	fftwf_free(vis_config->_d_freq_image);
-	fftwf_destroy_plan(vis_config->_plan);
-	fftwf_cleanup_threads();
+	free_images(vis_config);
+	memory_free(vis_config->_d_freq_image);
+	destroy_basis_function_tables(vis_config);
 	delete vis_config;
+	fft_threads_release();
 }
 
 void vis_config_compute_scale(VisConfig* vis_config)
@@ -142,68 +222,283 @@ void vis_config_compute_scale(VisConfig* vis_config)
 	vis_config->_scale = vis_config->step_size.x * vis_config->step_size.y;
 }
 
-template <typename T>
-T* load_into_device(T* h_data, int N, int integer_multiple_of, int& rounded_N)
+// Every parallel loop of the library asks for this many threads, and FFTW plans for it too.  Linked with FFTW's OpenMP threads (see
+// common.mk), FFTW then runs on the same OpenMP worker pool as the kernels, and since a render only does one thing at a time
+// the pool never competes with itself.  Renders running concurrently each get a pool of their own (with nested parallelism enabled).
+static int number_of_threads = 0;	// 0 until it's set or first asked for
+static std::vector<int> pinned_processors;
+
+int vis_get_number_of_threads()
 {
-	T* d_data;
-	if(h_data == 0)
+	int threads;
+	#pragma omp critical(vis_number_of_threads)
 	{
-		d_data = 0;
+		if(number_of_threads == 0) number_of_threads = omp_get_max_threads();	// which respects OMP_NUM_THREADS
+		threads = number_of_threads;
+	}
+	return threads;
+}
+
+#ifdef WIN32
+static DWORD_PTR unpinned_affinity = 0;
+#else
+static cpu_set_t unpinned_affinity;
+static bool has_unpinned_affinity = false;
+#endif
+
+// pins each of the pool's threads to its processor, or back to the processors it could use before, returns false if that failed
+static bool apply_thread_affinity()
+{
+	bool succeeded = true;
+	int threads = vis_get_number_of_threads();
+	#pragma omp parallel num_threads(threads) reduction(&&:succeeded)
+	{
+		int thread = omp_get_thread_num();
+#ifdef WIN32
+		DWORD_PTR mask = pinned_processors.empty() ? unpinned_affinity : (DWORD_PTR)1 << pinned_processors[thread % pinned_processors.size()];
+		succeeded = mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+		cpu_set_t mask;
+		if(pinned_processors.empty()) mask = unpinned_affinity;
+		else
+		{
+			CPU_ZERO(&mask);
+			CPU_SET(pinned_processors[thread % pinned_processors.size()], &mask);
+		}
+		succeeded = sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#endif
+	}
+	return succeeded;
+}
+
+void vis_set_number_of_threads(int threads)
+{
+	#pragma omp critical(vis_number_of_threads)
+	number_of_threads = threads > 0 ? threads : omp_get_max_threads();
+	if(!pinned_processors.empty()) apply_thread_affinity();	// the pool may have gained threads
+}
+
+bool vis_set_thread_affinity(const int* processors, int number_of_processors)
+{
+	if(number_of_processors > 0)
+	{
+		// remember what to go back to when they're unpinned
+#ifdef WIN32
+		DWORD_PTR system_affinity;
+		if(unpinned_affinity == 0) GetProcessAffinityMask(GetCurrentProcess(), &unpinned_affinity, &system_affinity);
+#else
+		if(!has_unpinned_affinity) has_unpinned_affinity = sched_getaffinity(0, sizeof(unpinned_affinity), &unpinned_affinity) == 0;
+		if(!has_unpinned_affinity) return false;
+#endif
+#ifdef WIN32
+		const int number_of_mask_bits = 8*sizeof(DWORD_PTR);
+#else
+		const int number_of_mask_bits = CPU_SETSIZE;
+#endif
+		for(int i = 0; i < number_of_processors; i++) if(processors[i] < 0 || processors[i] >= number_of_mask_bits) return false;
+		pinned_processors.assign(processors, processors + number_of_processors);
 	}
 	else
 	{
-		int k = (N / integer_multiple_of) + std::min(1, N%integer_multiple_of);
-		rounded_N = integer_multiple_of*k;
-		d_data = new T[rounded_N];
-		memset((void*)d_data, 0, sizeof(T)*rounded_N);
-		memcpy(d_data, h_data, sizeof(T)*N);
+		bool was_pinned = !pinned_processors.empty();
+		pinned_processors.clear();
+		if(!was_pinned) return true;
+	}
+	if(apply_thread_affinity()) return true;
+
+	// a processor the process may not use, say, so leave the threads unpinned
+	pinned_processors.clear();
+	apply_thread_affinity();
+	return false;
+}
+
+VisInstructionSet vis_get_supported_instruction_set()
+{
+#ifdef MESHLESS_VIS_HAVE_X86_SIMD
+	if(__builtin_cpu_supports("avx512f")) return VIS_AVX512;
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return VIS_AVX2;
+#endif
+	return VIS_SCALAR;
+}
+
+struct RadiusOrder
+{
+	const float* radii;
+	RadiusOrder(const float* radii) : radii(radii) {}
+	bool operator()(int a, int b) const { return radii[a] < radii[b]; }
+};
+
+// splits the constraints into zero padded x, y, z, weight and radius arrays so the kernels can load several consecutive terms at once.
+// The terms are sorted by increasing radius, so that the ones whose basis function is still significant at a given distance from
+// the origin are always a prefix of the arrays (see number_of_contributing_terms in fourier_transform_rings_cpu.h).
+void load_constraints_into_device(Group* group, int integer_multiple_of, VisConfig* vis_config)
+{
+	int k = (group->number_of_terms / integer_multiple_of) + std::min(1, group->number_of_terms%integer_multiple_of);
+	group->d_number_of_terms = integer_multiple_of*k;
+	group->d_constraints = 0;
+
+	std::vector<int> order(group->number_of_terms);
+	for(int i = 0; i < group->number_of_terms; i++) order[i] = i;
+	if(group->h_radii) std::stable_sort(order.begin(), order.end(), RadiusOrder(group->h_radii));
+
+	float** d_arrays[5] = { &group->d_x, &group->d_y, &group->d_z, &group->d_weights, &group->d_radii };
+	for(int i = 0; i != 5; i++)
+	{
+		*d_arrays[i] = 0;
+		if(i == 4 && group->h_radii == 0) continue;
+		*d_arrays[i] = (float*)memory_allocate(sizeof(float)*group->d_number_of_terms, vis_config->_huge_pages);
+	}
+
+	// the padding is filled in the same pass, so that with _parallel_first_touch every page is first written by one of the pool's threads
+	int i;
+	#pragma omp parallel for schedule(static) num_threads(vis_get_number_of_threads()) if(vis_config->_parallel_first_touch)
+	for(i = 0; i < group->d_number_of_terms; i++)
+	{
+		bool is_term = i < group->number_of_terms;
+		group->d_x[i] = is_term ? group->h_constraints[order[i]].position.x : 0.0f;
+		group->d_y[i] = is_term ? group->h_constraints[order[i]].position.y : 0.0f;
+		group->d_z[i] = is_term ? group->h_constraints[order[i]].position.z : 0.0f;
+		group->d_weights[i] = is_term ? group->h_constraints[order[i]].weight : 0.0f;
+		if(group->h_radii) group->d_radii[i] = is_term ? group->h_radii[order[i]] : 0.0f;
+	}
+}
+
+// When a group only has a few distinct radii (a constant smoothing length, say) the kernels evaluate the basis function once per
+// distinct radius for each ring of samples and look it up for each term, instead of evaluating it for every term and sample.
+const int max_distinct_radii = 256;
+
+void tabulate_distinct_radii(Group* group, VisConfig* vis_config)
+{
+	group->number_of_distinct_radii = 0;
+	group->d_distinct_radii = 0;
+	group->d_radius_indices = 0;
+	if(group->h_radii == 0 || group->number_of_terms == 0) return;
+
+	std::vector<float> distinct_radii(group->d_radii, group->d_radii + group->number_of_terms);
+	std::sort(distinct_radii.begin(), distinct_radii.end());
+	distinct_radii.erase(std::unique(distinct_radii.begin(), distinct_radii.end()), distinct_radii.end());
+	if((int)distinct_radii.size() > max_distinct_radii) return;
+
+	group->number_of_distinct_radii = (int)distinct_radii.size();
+	group->d_distinct_radii = (float*)fftwf_malloc(sizeof(float)*distinct_radii.size());
+	std::copy(distinct_radii.begin(), distinct_radii.end(), group->d_distinct_radii);
+
+	// the padding gets index 0, its weight is zero anyway
+	group->d_radius_indices = (int*)memory_allocate(sizeof(int)*group->d_number_of_terms, vis_config->_huge_pages);
+	int i;
+	#pragma omp parallel for schedule(static) num_threads(vis_get_number_of_threads()) if(vis_config->_parallel_first_touch)
+	for(i = 0; i < group->d_number_of_terms; i++)
+	{
+		group->d_radius_indices[i] = i < group->number_of_terms ? (int)(std::lower_bound(distinct_radii.begin(), distinct_radii.end(), group->d_radii[i]) - distinct_radii.begin()) : 0;
 	}
-	return d_data;
 }
 
 void vis_register_meshless_dataset(VisConfig* vis_config, MeshlessDataset* meshless_dataset)
 {
 	for(int j = 0; j != meshless_dataset->number_of_groups; j++)
 	{
-		meshless_dataset->groups[j].d_constraints = load_into_device(meshless_dataset->groups[j].h_constraints, meshless_dataset->groups[j].number_of_terms, vis_config->_number_of_partial_sums*vis_config->block_length, meshless_dataset->groups[j].d_number_of_terms);
-		meshless_dataset->groups[j].d_radii = load_into_device(meshless_dataset->groups[j].h_radii, meshless_dataset->groups[j].number_of_terms, vis_config->_number_of_partial_sums*vis_config->block_length, meshless_dataset->groups[j].d_number_of_terms);
+		load_constraints_into_device(meshless_dataset->groups+j, vis_config->block_length, vis_config);
+		meshless_dataset->groups[j].d_spectrum = 0;
+		meshless_dataset->groups[j].d_tree = 0;
+		tabulate_distinct_radii(meshless_dataset->groups+j, vis_config);
+		meshless_dataset->groups[j].d_replicas = vis_config->replicate_terms ? replicas_create(meshless_dataset->groups[j], vis_config->_huge_pages) : 0;
 	}
+	update_basis_function_tables(vis_config, meshless_dataset);
 }
 
 void vis_unregister_meshless_dataset(VisConfig* vis_config, MeshlessDataset* meshless_dataset)
 {
 	for(int j = 0; j != meshless_dataset->number_of_groups; j++)
 	{
-		free(meshless_dataset->groups[j].d_constraints);
-		free(meshless_dataset->groups[j].d_radii);
+		memory_free(meshless_dataset->groups[j].d_x);
+		memory_free(meshless_dataset->groups[j].d_y);
+		memory_free(meshless_dataset->groups[j].d_z);
+		memory_free(meshless_dataset->groups[j].d_weights);
+		memory_free(meshless_dataset->groups[j].d_radii);
+		spectrum_release(meshless_dataset->groups[j].d_spectrum);
+		tree_destroy(meshless_dataset->groups[j].d_tree);
+		replicas_destroy(meshless_dataset->groups[j].d_replicas);
+		if(meshless_dataset->groups[j].d_distinct_radii) fftwf_free(meshless_dataset->groups[j].d_distinct_radii);
+		memory_free(meshless_dataset->groups[j].d_radius_indices);
 	}
 }
 
 
-void reduce_partial_sums(VisConfig vis_config)
+// A registration registers a copy of the dataset's groups.  The creating config only decides where the terms are placed, and the
+// CPU kernels don't rely on the terms being padded to any particular length (culling pads to the rendering config's block_length),
+// so every config can render every registration.  The spectrum and octree are built by the first config that needs them.
+struct VisRegistration
 {
-	// this optimization is pointless for the CPU until there are something like 128 cores on a CPU
+	MeshlessDataset meshless_dataset;
+	int references;
+};
 
-	#if 0
-	int index, size, i;
-	fftwf_complex partial_sum;
-	int chunk = vis_config.block_length;
-	size = 2*vis_config._cutoff_frequency.x*vis_config._cutoff_frequency.y;
+VisRegistration* vis_registration_create(VisConfig* vis_config, MeshlessDataset* meshless_dataset)
+{
+	VisRegistration* registration = new VisRegistration;
+	registration->meshless_dataset = *meshless_dataset;
+	registration->meshless_dataset.groups = new Group[std::max(1, meshless_dataset->number_of_groups)];
+	std::copy(meshless_dataset->groups, meshless_dataset->groups + meshless_dataset->number_of_groups, registration->meshless_dataset.groups);
+	registration->references = 1;
+	vis_register_meshless_dataset(vis_config, &registration->meshless_dataset);
+
+	// nothing reads the host arrays after registration, so they may go before the registration does
+	for(int j = 0; j != meshless_dataset->number_of_groups; j++) registration->meshless_dataset.groups[j].h_constraints = 0, registration->meshless_dataset.groups[j].h_radii = 0;
+	return registration;
+}
+
+void vis_registration_retain(VisRegistration* registration)
+{
+	#pragma omp critical(vis_registration_references)
+	registration->references++;
+}
+
+void vis_registration_release(VisRegistration* registration)
+{
+	if(registration == 0) return;
+	int references;
+	#pragma omp critical(vis_registration_references)
+	references = --registration->references;
+	if(references > 0) return;
+
+	vis_unregister_meshless_dataset(0, &registration->meshless_dataset);
+	delete[] registration->meshless_dataset.groups;
+	delete registration;
+}
+
+bool vis_registration_is_compatible(VisRegistration* /*registration*/, VisConfig* /*vis_config*/)
+{
+	return true;
+}
 
-	#pragma omp parallel default(shared) private(index, partial_sum)
+// the term arrays, the distinct radii, the copies on other NUMA nodes and whichever spectra and octrees renders have built so far,
+// taken under the locks they're built under since another thread may be building or replacing them
+size_t vis_registration_size(VisRegistration* registration)
+{
+	size_t size = 0;
+	for(int j = 0; j != registration->meshless_dataset.number_of_groups; j++)
 	{
-		#pragma omp for schedule(dynamic,chunk) nowait
-		for(index = 0; index < size; index++)
-		{
-			complex_assign(partial_sum, vis_config._d_freq_image[index]);
-			for(i = 1; i < vis_config._number_of_partial_sums; i++)
-			{
-				complex_accumulate(partial_sum, vis_config._d_freq_image[index+i*size]);
-			}
-			complex_assign(vis_config._d_freq_image[index], partial_sum);
-		}
+		const Group& group = registration->meshless_dataset.groups[j];
+		size_t number_of_arrays = 4 + (group.d_radii != 0) + (group.d_radius_indices != 0);
+		size_t copies = 1;
+		if(group.d_replicas) for(int node = 0; node < group.d_replicas->number_of_nodes; node++) copies += group.d_replicas->is_replicated[node];
+		size += copies*sizeof(float)*(number_of_arrays*group.d_number_of_terms + group.number_of_distinct_radii);
+		#pragma omp critical(group_spectrum)
+		size += spectrum_size(group.d_spectrum);
+		#pragma omp critical(group_tree)
+		size += tree_size(group.d_tree);
 	}
-	#endif
+	return size;
+}
+
+void vis_registration_fourier_volume_rendering(VisRegistration* registration, VisConfig* vis_config)
+{
+	vis_fourier_volume_rendering(&registration->meshless_dataset, vis_config);
+}
+
+void vis_registration_opengl_fourier_volume_rendering(VisRegistration* registration, VisConfig* vis_config, GLuint buffer_object)
+{
+	vis_opengl_fourier_volume_rendering(&registration->meshless_dataset, vis_config, buffer_object);
 }
 
 void arrange_samples(VisConfig vis_config)
@@ -212,7 +507,7 @@ void arrange_samples(VisConfig vis_config)
 	int chunk = vis_config.block_length;
 	size = 2*vis_config._cutoff_frequency.x*vis_config._cutoff_frequency.y;
 
-	#pragma omp parallel default(shared) private(index, x, y, index_x)
+	#pragma omp parallel default(shared) private(index, x, y, index_x) num_threads(vis_get_number_of_threads())
 	{
 		#pragma omp for schedule(dynamic,chunk) nowait
 		for(index = 0; index < size; index++)
@@ -233,6 +528,129 @@ void arrange_samples(VisConfig vis_config)
 	}
 }
 
+// A term whose footprint, its projection onto the image plane give or take its radius, lies entirely outside one period of the
+// image only shows up as an alias of itself wrapped around from a neighbouring period.  The period is taken to be the one centered
+// on the origin, where the applications put their datasets.  The footprint of SPH's cubic spline is twice its radius, the smoothing
+// length, as is the gaussian's, where it has dropped to 1e-5 of its peak.  Wendland's vanishes beyond its radius.
+inline bool is_fully_aliased(const Group& group, int k, float half_width, float half_height, float3 u_axis, float3 v_axis)
+{
+	float radius = group.d_radii ? group.d_radii[k] : 1.0f;
+	if(group.basis_function_id != WENDLAND_D3_C2) radius *= 2.0f;
+	float u = u_axis.x*group.d_x[k] + u_axis.y*group.d_y[k] + u_axis.z*group.d_z[k];
+	float v = v_axis.x*group.d_x[k] + v_axis.y*group.d_y[k] + v_axis.z*group.d_z[k];
+	return std::fabs(u) - radius > half_width || std::fabs(v) - radius > half_height;
+}
+
+// culling works through the terms in blocks of this many, first masking the terms and counting the survivors of each block, then
+// (after an exclusive prefix sum over the counts gives each block its offset) copying them out, both in parallel
+const int cull_block_length = 16384;
+
+// copies the group's terms that aren't fully aliased into new zero padded arrays, keeping their order so they're still sorted by
+// radius.  Only the arrays are new, the rest (the distinct radii, for instance) is shared with the group.
+Group cull_fully_aliased_terms(const Group& group, VisConfig* vis_config)
+{
+	float half_width = 0.5f/vis_config->step_size.x, half_height = 0.5f/vis_config->step_size.y;
+	int number_of_blocks = (group.number_of_terms + cull_block_length - 1)/cull_block_length;
+	std::vector<unsigned char> mask(group.number_of_terms);
+	std::vector<int> offsets(number_of_blocks+1, 0);
+
+	int block;
+	#pragma omp parallel for schedule(dynamic) num_threads(vis_get_number_of_threads())
+	for(block = 0; block < number_of_blocks; block++)
+	{
+		int end = std::min(group.number_of_terms, (block+1)*cull_block_length), count = 0;
+		for(int k = block*cull_block_length; k < end; k++)
+		{
+			mask[k] = !is_fully_aliased(group, k, half_width, half_height, vis_config->u_axis, vis_config->v_axis);
+			count += mask[k];
+		}
+		offsets[block+1] = count;
+	}
+	for(int b = 0; b < number_of_blocks; b++) offsets[b+1] += offsets[b];
+
+	Group culled = group;
+	int integer_multiple_of = vis_config->block_length;
+	culled.number_of_terms = offsets[number_of_blocks];
+	culled.d_number_of_terms = integer_multiple_of*((culled.number_of_terms + integer_multiple_of - 1)/integer_multiple_of);
+	culled.d_spectrum = 0;
+	culled.d_tree = 0;
+	culled.d_replicas = 0;
+
+	float* const* arrays[5] = { &group.d_x, &group.d_y, &group.d_z, &group.d_weights, &group.d_radii };
+	float** culled_arrays[5] = { &culled.d_x, &culled.d_y, &culled.d_z, &culled.d_weights, &culled.d_radii };
+	for(int i = 0; i != 5; i++)
+	{
+		if(*arrays[i] == 0) continue;
+		*culled_arrays[i] = (float*)fftwf_malloc(sizeof(float)*std::max(1, culled.d_number_of_terms));
+		std::fill(*culled_arrays[i] + culled.number_of_terms, *culled_arrays[i] + culled.d_number_of_terms, 0.0f);
+	}
+	if(group.d_radius_indices)
+	{
+		culled.d_radius_indices = (int*)fftwf_malloc(sizeof(int)*std::max(1, culled.d_number_of_terms));
+		std::fill(culled.d_radius_indices + culled.number_of_terms, culled.d_radius_indices + culled.d_number_of_terms, 0);
+	}
+
+	#pragma omp parallel for schedule(dynamic) num_threads(vis_get_number_of_threads())
+	for(block = 0; block < number_of_blocks; block++)
+	{
+		int end = std::min(group.number_of_terms, (block+1)*cull_block_length), j = offsets[block];
+		for(int k = block*cull_block_length; k < end; k++)
+		{
+			if(!mask[k]) continue;
+			for(int i = 0; i != 5; i++) if(*arrays[i]) (*culled_arrays[i])[j] = (*arrays[i])[k];
+			if(group.d_radius_indices) culled.d_radius_indices[j] = group.d_radius_indices[k];
+			j++;
+		}
+	}
+	return culled;
+}
+
+void free_culled_group(Group* culled)
+{
+	fftwf_free(culled->d_x);
+	fftwf_free(culled->d_y);
+	fftwf_free(culled->d_z);
+	fftwf_free(culled->d_weights);
+	if(culled->d_radii) fftwf_free(culled->d_radii);
+	if(culled->d_radius_indices) fftwf_free(culled->d_radius_indices);
+}
+
+// The spectrum and the octree cached for VIS_SPECTRUM_SLICE and VIS_HIERARCHICAL hold all of a group's terms and are meant to be
+// reused as the view changes, so those methods don't cull.
+void fourier_transform_culled(MeshlessDataset* meshless_dataset, VisConfig* vis_config, bool accumulate)
+{
+	if(vis_config->sampling_method == VIS_SPECTRUM_SLICE || vis_config->sampling_method == VIS_HIERARCHICAL)
+	{
+		if(accumulate) fourier_transform_accumulate(meshless_dataset, vis_config);
+		else           fourier_transform(meshless_dataset, vis_config);
+		return;
+	}
+
+	std::vector<Group> culled_groups(meshless_dataset->number_of_groups);
+	for(int j = 0; j != meshless_dataset->number_of_groups; j++) culled_groups[j] = cull_fully_aliased_terms(meshless_dataset->groups[j], vis_config);
+
+	MeshlessDataset culled_dataset = *meshless_dataset;
+	culled_dataset.groups = culled_groups.empty() ? 0 : &culled_groups[0];
+	if(accumulate) fourier_transform_accumulate(&culled_dataset, vis_config);
+	else           fourier_transform(&culled_dataset, vis_config);
+
+	for(int j = 0; j != meshless_dataset->number_of_groups; j++) free_culled_group(&culled_groups[j]);
+}
+
+// arranges the samples, unless the kernels already have or there are none, and runs the inverse FFT into _d_image
+void transform_samples(VisConfig* vis_config, bool arrange)
+{
+	if(!vis_config->_arrange_samples_in_kernels && arrange)
+	{
+		arrange_samples(*vis_config);
+	}
+
+	// the plans may have been made for other arrays, aligned the same way
+	FFTPlans plans = fft_plans_get(vis_config);
+	fftwf_execute_dft(plans.columns, vis_config->_d_freq_image_arranged, vis_config->_d_freq_image_arranged);
+	fftwf_execute_dft_c2r(plans.rows, vis_config->_d_freq_image_arranged, vis_config->_d_image);
+}
+
 void vis_opengl_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config, GLuint registered_buffer_object)
 {
 	vis_fourier_volume_rendering(meshless_dataset, vis_config);
@@ -249,16 +667,59 @@ void vis_opengl_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisC
 
 void vis_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config)
 {
-	memset((void*)vis_config->_d_freq_image_arranged, 0, sizeof(float2)*vis_config->_number_of_samples.x*(vis_config->_number_of_samples.y/2+1));
-	fourier_transform(meshless_dataset, vis_config);
+	// the last frame's column transforms filled the rows between the positive and negative frequencies, and every row if there's
+	// nothing to sample this time
+	int row_length = vis_config->_number_of_samples.y/2+1;
+	bool is_empty = meshless_dataset->number_of_groups < 1;
+	int first_cleared_row = is_empty ? 0 : vis_config->_cutoff_frequency.x;
+	int last_cleared_row = is_empty ? vis_config->_number_of_samples.x : vis_config->_number_of_samples.x-vis_config->_cutoff_frequency.x+1;
+	for(int x = first_cleared_row; x < last_cleared_row; x++)
+	{
+		memset((void*)(vis_config->_d_freq_image_arranged + x*row_length), 0, sizeof(fftwf_complex)*vis_config->_cutoff_frequency.y);
+	}
+	if(vis_config->cull_fully_aliased_terms) fourier_transform_culled(meshless_dataset, vis_config, false);
+	else                                     fourier_transform(meshless_dataset, vis_config);
 
-	if(vis_config->_number_of_partial_sums > 1)
+	transform_samples(vis_config, !is_empty);
+}
+
+// while one chunk is registered and summed the next one's pages are already being read in
+void vis_out_of_core_fourier_volume_rendering(MeshlessDataset* meshless_dataset, VisConfig* vis_config, int chunk_terms)
+{
+	// every chunk is added to the samples, so they all start out zero
+	clear_arranged_samples(vis_config);
+	if(vis_config->_d_freq_image) memset((void*)vis_config->_d_freq_image, 0, sizeof(fftwf_complex)*2*vis_config->_cutoff_frequency.x*vis_config->_cutoff_frequency.y);
+
+	chunk_terms = std::max(1, chunk_terms);
+	int j = 0, first_term = 0;
+	while(j < meshless_dataset->number_of_groups && meshless_dataset->groups[j].number_of_terms == 0) j++;
+	if(j < meshless_dataset->number_of_groups) meshless_dataset_prefetch_terms(meshless_dataset, j, 0, chunk_terms);
+	while(j < meshless_dataset->number_of_groups)
 	{
-		reduce_partial_sums(*vis_config);
+		Group chunk = meshless_dataset->groups[j];
+		chunk.h_constraints += first_term;
+		if(chunk.h_radii) chunk.h_radii += first_term;
+		chunk.number_of_terms = std::min(chunk_terms, meshless_dataset->groups[j].number_of_terms - first_term);
+
+		// on to the next chunk, skipping empty groups, and start reading it
+		first_term += chunk.number_of_terms;
+		if(first_term == meshless_dataset->groups[j].number_of_terms)
+		{
+			first_term = 0;
+			do j++; while(j < meshless_dataset->number_of_groups && meshless_dataset->groups[j].number_of_terms == 0);
+		}
+		if(j < meshless_dataset->number_of_groups) meshless_dataset_prefetch_terms(meshless_dataset, j, first_term, chunk_terms);
+
+		MeshlessDataset chunk_dataset = *meshless_dataset;
+		chunk_dataset.groups = &chunk;
+		chunk_dataset.number_of_groups = 1;
+		vis_register_meshless_dataset(vis_config, &chunk_dataset);
+		if(vis_config->cull_fully_aliased_terms) fourier_transform_culled(&chunk_dataset, vis_config, true);
+		else                                     fourier_transform_accumulate(&chunk_dataset, vis_config);
+		vis_unregister_meshless_dataset(vis_config, &chunk_dataset);
 	}
-	arrange_samples(*vis_config);
 
-	fftwf_execute(vis_config->_plan);
+	transform_samples(vis_config, true);
 }
 
 void vis_copy_to_host(VisConfig* vis_config, float* h_image)
@@ -0,0 +1,126 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "meshless_vis.h"
+#include <vector>
+
+// see VisRegistrationCache in meshless_vis.h, there are few enough datasets that a linear search does
+struct CachedRegistration
+{
+	Group* groups;			// identifies the dataset
+	int generation;
+	VisRegistration* registration;
+	size_t size;
+	unsigned long long last_used;
+};
+
+struct VisRegistrationCache
+{
+	size_t budget, size;
+	unsigned long long clock;
+	std::vector<CachedRegistration> entries;
+};
+
+VisRegistrationCache* vis_registration_cache_create(size_t budget)
+{
+	VisRegistrationCache* cache = new VisRegistrationCache;
+	cache->budget = budget;
+	cache->size = 0;
+	cache->clock = 0;
+	return cache;
+}
+
+static void remove_entry(VisRegistrationCache* cache, int i)
+{
+	cache->size -= cache->entries[i].size;
+	vis_registration_release(cache->entries[i].registration);
+	cache->entries.erase(cache->entries.begin() + i);
+}
+
+static int find_entry(VisRegistrationCache* cache, Group* groups)
+{
+	for(int i = 0; i != (int)cache->entries.size(); i++) if(cache->entries[i].groups == groups) return i;
+	return -1;
+}
+
+void vis_registration_cache_destroy(VisRegistrationCache* cache)
+{
+	if(cache == 0) return;
+	while(!cache->entries.empty()) remove_entry(cache, (int)cache->entries.size()-1);
+	delete cache;
+}
+
+VisRegistration* vis_registration_cache_get(VisRegistrationCache* cache, VisConfig* vis_config, MeshlessDataset* meshless_dataset)
+{
+	VisRegistration* registration;
+	#pragma omp critical(vis_registration_cache)
+	{
+		int found = find_entry(cache, meshless_dataset->groups);
+		if(found >= 0 && (cache->entries[found].generation != meshless_dataset->generation || !vis_registration_is_compatible(cache->entries[found].registration, vis_config)))
+		{
+			remove_entry(cache, found);
+			found = -1;
+		}
+		if(found < 0)
+		{
+			CachedRegistration entry;
+			entry.groups = meshless_dataset->groups;
+			entry.generation = meshless_dataset->generation;
+			entry.registration = vis_registration_create(vis_config, meshless_dataset);
+			entry.size = 0;
+			cache->entries.push_back(entry);
+			found = (int)cache->entries.size()-1;
+		}
+		cache->entries[found].last_used = ++cache->clock;
+		registration = cache->entries[found].registration;
+		vis_registration_retain(registration);
+
+		// the spectra and octrees are built by the renders after a registration was added
+		cache->size = 0;
+		for(int i = 0; i != (int)cache->entries.size(); i++)
+		{
+			cache->entries[i].size = vis_registration_size(cache->entries[i].registration);
+			cache->size += cache->entries[i].size;
+		}
+
+		// released registrations are only freed once whoever is rendering them releases them too
+		while(cache->size > cache->budget && cache->entries.size() > 1)
+		{
+			int least_recently_used = -1;
+			for(int i = 0; i != (int)cache->entries.size(); i++)
+			{
+				if(cache->entries[i].registration == registration) continue;
+				if(least_recently_used < 0 || cache->entries[i].last_used < cache->entries[least_recently_used].last_used) least_recently_used = i;
+			}
+			remove_entry(cache, least_recently_used);
+		}
+	}
+	return registration;
+}
+
+void vis_registration_cache_forget(VisRegistrationCache* cache, MeshlessDataset* meshless_dataset)
+{
+	#pragma omp critical(vis_registration_cache)
+	{
+		int found = find_entry(cache, meshless_dataset->groups);
+		if(found >= 0) remove_entry(cache, found);
+	}
+}
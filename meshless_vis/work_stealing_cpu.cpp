@@ -0,0 +1,91 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "work_stealing_cpu.h"
+#include <algorithm>
+
+// with _number_of_partial_sums at 0, how many tasks each thread should have to balance the load
+const int tasks_per_thread = 4;
+
+WorkStealingTasks::WorkStealingTasks(int number_of_tasks, int number_of_threads)
+{
+	number_of_shares = std::max(1, number_of_threads);
+	shares = new Share[number_of_shares];
+	for(int i = 0; i < number_of_shares; i++)
+	{
+		omp_init_lock(&shares[i].lock);
+		shares[i].begin = (int)((long long)number_of_tasks*i/number_of_shares);
+		shares[i].end = (int)((long long)number_of_tasks*(i+1)/number_of_shares);
+	}
+}
+
+WorkStealingTasks::~WorkStealingTasks()
+{
+	for(int i = 0; i < number_of_shares; i++) omp_destroy_lock(&shares[i].lock);
+	delete[] shares;
+}
+
+bool WorkStealingTasks::next(int& task)
+{
+	// a team smaller than asked for leaves some shares without an owner, they get stolen
+	int thread = omp_get_thread_num() % number_of_shares;
+	Share& own = shares[thread];
+
+	omp_set_lock(&own.lock);
+	bool found = own.begin < own.end;
+	if(found) task = own.begin++;
+	omp_unset_lock(&own.lock);
+	if(found) return true;
+
+	// Once a thread has looked at every other share and found them all empty it's done, any tasks it missed were being moved by
+	// another thread, which will run them.
+	for(int i = 1; i < number_of_shares; i++)
+	{
+		Share& victim = shares[(thread + i) % number_of_shares];
+		omp_set_lock(&victim.lock);
+		int remaining = victim.end - victim.begin, begin = 0, end = 0;
+		if(remaining > 0)
+		{
+			begin = victim.end - (remaining + 1)/2, end = victim.end;
+			victim.end = begin;
+		}
+		omp_unset_lock(&victim.lock);
+		if(remaining <= 0) continue;
+
+		task = begin;
+		omp_set_lock(&own.lock);
+		own.begin = begin + 1, own.end = end;
+		omp_unset_lock(&own.lock);
+		return true;
+	}
+	return false;
+}
+
+int number_of_term_partitions(const VisConfig& vis_config, int number_of_tiles, int number_of_chunks)
+{
+	int number_of_partitions = vis_config._number_of_partial_sums;
+	if(number_of_partitions <= 0)
+	{
+		int number_of_tasks = tasks_per_thread*vis_get_number_of_threads();
+		number_of_partitions = (number_of_tasks + std::max(1, number_of_tiles) - 1)/std::max(1, number_of_tiles);
+	}
+	return std::max(1, std::min(number_of_partitions, number_of_chunks));
+}
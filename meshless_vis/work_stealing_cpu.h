@@ -0,0 +1,59 @@
+/*
+
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef WORK_STEALING_CPU_H_
+#define WORK_STEALING_CPU_H_
+
+#include "meshless_vis.h"
+#include <omp.h>
+
+// Hands out the tasks 0 ... number_of_tasks-1 to the threads of a parallel region.  Each thread starts with a contiguous share and
+// takes its tasks from the front, a thread that has run out steals the back half of another thread's share.  The kernels number
+// their tasks so that neighbouring ones share data, which mostly keeps that data on one thread.
+class WorkStealingTasks
+{
+public:
+	WorkStealingTasks(int number_of_tasks, int number_of_threads);
+	~WorkStealingTasks();
+
+	// the calling thread's next task, false once every task has been taken
+	bool next(int& task);
+
+private:
+	struct Share
+	{
+		omp_lock_t lock;
+		int begin, end;
+		char padding[64];	// keeps the threads' shares on separate cache lines
+	};
+	Share* shares;
+	int number_of_shares;
+
+	WorkStealingTasks(const WorkStealingTasks&);
+	WorkStealingTasks& operator=(const WorkStealingTasks&);
+};
+
+// The direct summation kernels split a group's terms into this many partitions (at chunk boundaries) and run a task for every tile
+// of samples and partition, each summing into its own partial sums, which are added up afterwards.  _number_of_partial_sums sets it,
+// 0 picks enough partitions to give each thread a few tasks when there are only a few tiles.  It never exceeds the number of chunks.
+int number_of_term_partitions(const VisConfig& vis_config, int number_of_tiles, int number_of_chunks);
+
+#endif /*WORK_STEALING_CPU_H_*/
@@ -1,6 +1,7 @@
 #emu := 1
 #dbg := 1
 #cpu := 1
+#CPU_CXX := g++-9
 
 MESHLESS_VIS_PATH := ..
 CUDA_INSTALL_PATH := /usr/local/cuda
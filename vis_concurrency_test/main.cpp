@@ -0,0 +1,169 @@
+/*
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Checks the CPU library's thread safety (see meshless_vis.h): renders a dataset with a number of configs one at a time, then all at
+// once from as many threads, each creating and destroying its config there too, and compares every config's two images.  The configs
+// differ in sampling method, view, step size, number of samples, tolerances, culling and FFT planning, so that they share the group's
+// spectrum and octree, the FFT plans and a registration while each needs something different of them.  Returns 1 if any image differs by more
+// than its method allows, so that "make -f makefile_cpu test" fails.
+//   vis_concurrency_test [number_of_configs = 10 [number_of_runs = 3 [number_of_terms = 3000]]]
+
+#include "meshless_vis.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+const VisSamplingMethod sampling_methods[5] = {VIS_DIRECT_SUMMATION, VIS_PHASE_RECURRENCE, VIS_NUFFT, VIS_SPECTRUM_SLICE, VIS_HIERARCHICAL};
+const char* sampling_method_names[5] = {"direct summation", "phase recurrence", "NUFFT", "spectrum slice", "hierarchical"};
+
+float random_float(float low, float high)
+{
+	return low + (high-low)*(std::rand()/(float)RAND_MAX);
+}
+
+// Random terms over and a little past the widest window of the configs, in a group with a radius per term, a group sharing one radius
+// (the only kind the NUFFT, the spectrum and the octree handle) and a group without radii.
+MeshlessDataset create_dataset(int number_of_terms)
+{
+	const BasisFunctionId basis_function_ids[3] = {SPH, GAUSSIAN, WENDLAND_D3_C2};
+	MeshlessDataset meshless_dataset;
+	meshless_dataset.number_of_groups = 3;
+	meshless_dataset.generation = 0;
+	meshless_dataset.mapping = 0;
+	meshless_dataset.groups = new Group[3];
+	for(int j = 0; j < 3; j++)
+	{
+		Group& group = meshless_dataset.groups[j];
+		group.basis_function_id = basis_function_ids[j];
+		group.number_of_terms = number_of_terms/(j+1);
+		group.h_constraints = new Constraint[group.number_of_terms];
+		group.h_radii = j == 2 ? 0 : new float[group.number_of_terms];
+		for(int k = 0; k < group.number_of_terms; k++)
+		{
+			group.h_constraints[k].position = make_float3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f));
+			group.h_constraints[k].weight = random_float(-0.5f, 1.0f);
+			if(j == 0) group.h_radii[k] = random_float(0.05f, 0.4f);
+			if(j == 1) group.h_radii[k] = 0.15f;
+		}
+	}
+	return meshless_dataset;
+}
+
+VisConfig* create_config(int i)
+{
+	float step_size = 1.0f/(1.0f + 0.25f*(i % 4));
+	float angle = 0.4f*i;
+	int2 number_of_samples = i % 3 ? make_int2(32, 32) : make_int2(48, 40);
+	VisConfig* vis_config = vis_config_create(true, make_float2(step_size, step_size), make_int2(12, 12), make_float3(std::cos(angle), std::sin(angle), 0.0f), make_float3(0.0f, 0.0f, 1.0f), number_of_samples, 64, 0);
+	vis_config->sampling_method = sampling_methods[i % 5];
+	// alternating tolerances make the configs replace the shared spectrum while others slice it
+	vis_config->nufft_tolerance = (i/5) % 2 ? 1.0e-6f : 1.0e-5f;
+	vis_config->cull_fully_aliased_terms = (i/2) % 2 != 0;
+	vis_config->basis_function_tolerance = i % 3 == 2 ? 1.0e-6f : 0.0f;
+	vis_config_arrange_samples_in_kernels(vis_config, i % 4 == 3);
+	// configs of the same size asking for measured plans replace the estimated ones the others may be running
+	vis_config->fft_planning = (i/3) % 2 ? VIS_FFT_MEASURE : VIS_FFT_ESTIMATE;
+	return vis_config;
+}
+
+// The exact methods only round differently with a different number of threads, the others may find the shared spectrum built for
+// another config, which only has to be as accurate
+float allowed_difference(int i)
+{
+	VisSamplingMethod sampling_method = sampling_methods[i % 5];
+	if(sampling_method == VIS_SPECTRUM_SLICE || sampling_method == VIS_HIERARCHICAL) return 1.0e-3f;
+	return 1.0e-5f;
+}
+
+// The configs using phase recurrence and the spectrum render through a registration, the others the registered dataset, so that the
+// configs of each method share the same groups
+void render(int i, MeshlessDataset* meshless_dataset, VisRegistration* registration, int number_of_runs, std::vector<float>& image)
+{
+	VisConfig* vis_config = create_config(i);
+	bool through_registration = (i % 5) % 2 != 0;
+	if(through_registration) vis_registration_retain(registration);
+	for(int k = 0; k < number_of_runs; k++)
+	{
+		if(through_registration) vis_registration_fourier_volume_rendering(registration, vis_config);
+		else                     vis_fourier_volume_rendering(meshless_dataset, vis_config);
+	}
+	if(through_registration) vis_registration_release(registration);
+	image.resize(vis_config->_number_of_samples.x*vis_config->_number_of_samples.y);
+	vis_copy_to_host(vis_config, &image[0]);
+	vis_config_destroy(vis_config);
+}
+
+int main(int argc, char** argv)
+{
+	int number_of_configs = argc > 1 ? std::atoi(argv[1]) : 10;
+	int number_of_runs = argc > 2 ? std::atoi(argv[2]) : 3;
+	int number_of_terms = argc > 3 ? std::atoi(argv[3]) : 3000;
+	std::cout << number_of_configs << " configs, " << number_of_runs << " runs each, " << number_of_terms << " terms" << std::endl;
+
+	MeshlessDataset meshless_dataset = create_dataset(number_of_terms);
+	VisConfig* registering_config = vis_config_get_default();
+	VisRegistration* registration = vis_registration_create(registering_config, &meshless_dataset);
+	vis_register_meshless_dataset(registering_config, &meshless_dataset);
+
+	std::vector<std::vector<float> > serial_images(number_of_configs), concurrent_images(number_of_configs);
+	for(int i = 0; i < number_of_configs; i++) render(i, &meshless_dataset, registration, number_of_runs, serial_images[i]);
+
+	// registering again and forgetting the plans, so that the concurrent configs build the spectrum, the octree and the plans again and
+	// replace each other's while they're being used
+	vis_unregister_meshless_dataset(registering_config, &meshless_dataset);
+	vis_registration_release(registration);
+	vis_fft_forget_plans();
+	registration = vis_registration_create(registering_config, &meshless_dataset);
+	vis_register_meshless_dataset(registering_config, &meshless_dataset);
+
+	int nested = omp_get_nested();
+	omp_set_nested(1);
+	int i;
+	#pragma omp parallel for schedule(static,1) num_threads(number_of_configs)
+	for(i = 0; i < number_of_configs; i++) render(i, &meshless_dataset, registration, number_of_runs, concurrent_images[i]);
+	omp_set_nested(nested);
+
+	bool passed = true;
+	for(i = 0; i < number_of_configs; i++)
+	{
+		float largest_value = 0.0f, difference = 0.0f;
+		for(size_t j = 0; j < serial_images[i].size(); j++)
+		{
+			largest_value = std::max(largest_value, std::fabs(serial_images[i][j]));
+			difference = std::max(difference, std::fabs(serial_images[i][j] - concurrent_images[i][j]));
+		}
+		bool matches = largest_value > 0.0f && difference <= allowed_difference(i)*largest_value;
+		std::cout << "config " << i << " (" << sampling_method_names[i % 5] << "): relative difference " << (largest_value > 0.0f ? difference/largest_value : difference)
+		          << (matches ? "" : (largest_value > 0.0f ? ", FAILED" : ", FAILED, empty image")) << std::endl;
+		passed = passed && matches;
+	}
+
+	vis_unregister_meshless_dataset(registering_config, &meshless_dataset);
+	vis_registration_release(registration);
+	vis_config_destroy(registering_config);
+	delete_meshless_dataset(meshless_dataset);
+	vis_fft_forget_plans();
+
+	std::cout << (passed ? "passed" : "FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/*
+libMeshlessVis
+Copyright (C) 2008 Andrew Corrigan
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Checks cull_fully_aliased_terms (see meshless_vis.h) against the support of each basis function: terms whose centers lie within one
+// support of the edge of the window, on either side, still overlap it and must render the same culled as not, while terms lying
+// further out must all be culled, leaving an empty image.  Each sampling method that culls renders both datasets.  Returns 1 if a
+// check fails, so that "make -f makefile_cpu test" fails.  Each basis function gets datasets of its own, since the gaussian's samples
+// grow so quickly with the frequency that they'd hide the others'.
+//   vis_culling_test [number_of_terms = 300]
+
+#include "meshless_vis.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+const VisSamplingMethod sampling_methods[3] = {VIS_DIRECT_SUMMATION, VIS_PHASE_RECURRENCE, VIS_NUFFT};
+const char* sampling_method_names[3] = {"direct summation", "phase recurrence", "NUFFT"};
+const BasisFunctionId basis_function_ids[3] = {SPH, GAUSSIAN, WENDLAND_D3_C2};
+const char* basis_function_names[3] = {"SPH", "gaussian", "Wendland"};
+
+// the configs view the window [-0.5, 0.5] of the xy plane
+const float half_width = 0.5f;
+
+float random_float(float low, float high)
+{
+	return low + (high-low)*(std::rand()/(float)RAND_MAX);
+}
+
+// SPH's radius is the smoothing length of its cubic spline, which reaches twice that, the gaussian is taken to reach twice its radius
+// as the library does, and Wendland's function vanishes beyond its radius, which is 1 for a group without radii
+float support(BasisFunctionId basis_function_id, float radius)
+{
+	return basis_function_id == WENDLAND_D3_C2 ? radius : 2.0f*radius;
+}
+
+// A group of the j-th basis function, SPH with a radius per term, the gaussian sharing one radius and Wendland without radii, whose
+// terms' centers lie between lowest_fraction and highest_fraction of their support outside one of the window's four edges (inside it
+// for negative fractions) and within the window along the other axis.
+MeshlessDataset create_dataset(int j, int number_of_terms, float lowest_fraction, float highest_fraction)
+{
+	MeshlessDataset meshless_dataset;
+	meshless_dataset.number_of_groups = 1;
+	meshless_dataset.generation = 0;
+	meshless_dataset.mapping = 0;
+	meshless_dataset.groups = new Group[1];
+	Group& group = meshless_dataset.groups[0];
+	group.basis_function_id = basis_function_ids[j];
+	group.number_of_terms = number_of_terms;
+	group.h_constraints = new Constraint[number_of_terms];
+	group.h_radii = j == 2 ? 0 : new float[number_of_terms];
+	for(int k = 0; k < number_of_terms; k++)
+	{
+		float radius = j == 0 ? random_float(0.05f, 0.3f) : (j == 1 ? 0.2f : 1.0f);
+		if(group.h_radii) group.h_radii[k] = radius;
+		float across = half_width + random_float(lowest_fraction, highest_fraction)*support(group.basis_function_id, radius);
+		float along = random_float(-half_width, half_width);
+		if(k % 2) across = -across;
+		float3 position = k % 4 < 2 ? make_float3(across, along, 0.0f) : make_float3(along, across, 0.0f);
+		position.z = random_float(-half_width, half_width);
+		group.h_constraints[k].position = position;
+		group.h_constraints[k].weight = random_float(0.5f, 1.0f);
+	}
+	return meshless_dataset;
+}
+
+std::vector<float> render(MeshlessDataset* meshless_dataset, int method, bool cull_fully_aliased_terms)
+{
+	VisConfig* vis_config = vis_config_create(true, make_float2(1.0f, 1.0f), make_int2(12, 12), make_float3(1.0f, 0.0f, 0.0f), make_float3(0.0f, 1.0f, 0.0f), make_int2(32, 32), 64, 0);
+	vis_config->sampling_method = sampling_methods[method];
+	vis_config->cull_fully_aliased_terms = cull_fully_aliased_terms;
+	vis_register_meshless_dataset(vis_config, meshless_dataset);
+	vis_fourier_volume_rendering(meshless_dataset, vis_config);
+	vis_unregister_meshless_dataset(vis_config, meshless_dataset);
+	std::vector<float> image(vis_config->_number_of_samples.x*vis_config->_number_of_samples.y);
+	vis_copy_to_host(vis_config, &image[0]);
+	vis_config_destroy(vis_config);
+	return image;
+}
+
+float largest_value(const std::vector<float>& image)
+{
+	float largest = 0.0f;
+	for(size_t j = 0; j < image.size(); j++) largest = std::max(largest, std::fabs(image[j]));
+	return largest;
+}
+
+int main(int argc, char** argv)
+{
+	int number_of_terms = argc > 1 ? std::atoi(argv[1]) : 300;
+	std::cout << number_of_terms << " terms" << std::endl;
+
+	bool passed = true;
+	for(int j = 0; j < 3; j++)
+	{
+		MeshlessDataset overlapping = create_dataset(j, number_of_terms, -0.98f, 0.98f);
+		MeshlessDataset outside = create_dataset(j, number_of_terms, 1.02f, 2.0f);
+		for(int method = 0; method < 3; method++)
+		{
+			std::vector<float> unculled = render(&overlapping, method, false), culled = render(&overlapping, method, true);
+			float largest = largest_value(unculled), difference = 0.0f;
+			for(size_t i = 0; i < unculled.size(); i++) difference = std::max(difference, std::fabs(unculled[i] - culled[i]));
+			bool matches = largest > 0.0f && difference <= 1.0e-5f*largest;
+			std::cout << basis_function_names[j] << ", " << sampling_method_names[method] << ", overlapping terms: relative difference "
+			          << (largest > 0.0f ? difference/largest : difference) << (matches ? "" : (largest > 0.0f ? ", FAILED" : ", FAILED, empty image")) << std::endl;
+
+			float remaining = largest_value(render(&outside, method, true));
+			bool empty = remaining == 0.0f;
+			std::cout << basis_function_names[j] << ", " << sampling_method_names[method] << ", outside terms: largest value " << remaining << (empty ? "" : ", FAILED") << std::endl;
+			passed = passed && matches && empty;
+		}
+		delete_meshless_dataset(overlapping);
+		delete_meshless_dataset(outside);
+	}
+	vis_fft_forget_plans();
+
+	std::cout << (passed ? "passed" : "FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -25,6 +25,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include <Magick++.h> 
 
+// how much the registrations kept between renders may take, see VisRegistrationCache
+const size_t registration_cache_budget = (size_t)512 << 20;
 
 void save_rgb_float_image_to_file(const char* file_name, float*& rgb_image, int width, int height)
 {
@@ -36,21 +38,28 @@ void save_rgb_float_image_to_file(const char* file_name, float*& rgb_image, int
 
 int main(int argc, char** argv)
 {
-	MeshlessDataset* meshless_datasets;
-	int number_of_meshless_datasets;
 	std::string file_name("../data/cartwheel.sph");
 	std::string name_prefix("image_");
 	if(argc > 1) file_name = argv[1];
 	if(argc > 2) name_prefix = argv[2];
-	load_meshless_datasets_from_file(file_name.c_str(), &meshless_datasets, &number_of_meshless_datasets);
-	shift_meshless_datasets(meshless_datasets, number_of_meshless_datasets, -5.0f,-5.0f,-5.0f);
+	// the timesteps are loaded one at a time as they are rendered
+	MeshlessDatasetReader* meshless_dataset_reader = meshless_dataset_reader_open(file_name.c_str());
+	if(meshless_dataset_reader == 0)
+	{
+		std::cerr << "couldn't open " << file_name << std::endl;
+		return 1;
+	}
 	VisConfig* vis_config = vis_config_get_default();
+	VisRegistrationCache* registration_cache = vis_registration_cache_create(registration_cache_budget);
 
 
 	float* h_image = new float[vis_config->_number_of_samples.x*vis_config->_number_of_samples.y];
 	float* rgb_image = new float[vis_config->_number_of_samples.x*vis_config->_number_of_samples.y*3];
-	for(unsigned int k = 0; k != number_of_meshless_datasets; ++k)
+	for(MeshlessDataset* meshless_dataset = meshless_dataset_reader_next(meshless_dataset_reader); meshless_dataset != 0; meshless_dataset = meshless_dataset_reader_next(meshless_dataset_reader))
 	{
+		int k = meshless_dataset_reader_get_index(meshless_dataset_reader);
+		shift_meshless_dataset(meshless_dataset, -5.0f,-5.0f,-5.0f);
+
 		std::string name = name_prefix;
 		if(k < 10) name += "0";
 		if(k < 100) name += "0";
@@ -60,11 +69,12 @@ int main(int argc, char** argv)
 		name += ".jpg";
 		std::cout << name << std::endl;
 
-		MeshlessDataset meshless_dataset = meshless_datasets[k];
-		vis_register_meshless_dataset(vis_config, &meshless_dataset);
-		vis_fourier_volume_rendering(&meshless_dataset, vis_config);
-		vis_unregister_meshless_dataset(vis_config, &meshless_dataset);
+		VisRegistration* registration = vis_registration_cache_get(registration_cache, vis_config, meshless_dataset);
+		vis_registration_fourier_volume_rendering(registration, vis_config);
+		vis_registration_release(registration);
 		vis_copy_to_host(vis_config, h_image);
+		// each timestep is rendered once, so its registration goes with it
+		vis_registration_cache_forget(registration_cache, meshless_dataset);
 
 		
 		{
@@ -86,8 +96,9 @@ int main(int argc, char** argv)
 
 	delete[] rgb_image;
 	delete[] h_image;
+	vis_registration_cache_destroy(registration_cache);
 	vis_config_destroy(vis_config);
 
-	delete_meshless_datasets(meshless_datasets, number_of_meshless_datasets);
+	meshless_dataset_reader_close(meshless_dataset_reader);
 	return 0;
 }
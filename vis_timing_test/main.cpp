@@ -21,14 +21,28 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include <iostream>
 #include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#ifdef _LIBMESHLESSVIS_USE_CPU
+#include <omp.h>
+#endif
 
 int main(int argc, char** argv)
 {
-	if(argc != 8)
+	if(argc < 8)
 	{
-		std::cout << std::endl << "vis_timing_test number_of_runs number_of_terms cutoff_frequency block_length number_of_samples factor number_of_partial_sums" << std::endl;
+		std::cout << std::endl << "vis_timing_test number_of_runs number_of_terms cutoff_frequency block_length number_of_samples factor number_of_partial_sums [options]" << std::endl;
 		std::cout << "a good value for block length is 256" << std::endl;
-		std::cout << "factor should usually be 0, 1 is a special case that should be faster" << std::endl << std::endl;
+		std::cout << "factor should usually be 0, 1 is a special case that should be faster" << std::endl;
+		std::cout << "options for the CPU version:" << std::endl;
+		std::cout << "  --wisdom file          measure the FFT plans before timing, reusing and updating the wisdom in the file" << std::endl;
+		std::cout << "  --threads n            run on n threads" << std::endl;
+		std::cout << "  --pin                  pin thread i to processor i" << std::endl;
+		std::cout << "  --first-touch          first touch the buffers and terms from the threads that use them" << std::endl;
+		std::cout << "  --replicate            copy the terms to every NUMA node" << std::endl;
+		std::cout << "  --huge-pages mode      back the buffers and terms with transparent or explicit huge pages" << std::endl << std::endl;
 		return 0;
 	}
 
@@ -59,8 +73,52 @@ int main(int argc, char** argv)
 	number_of_samples.y = number_of_samples.x;
 	cutoff_frequency.y = cutoff_frequency.x;
 	
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	const char* fft_wisdom_filename = 0;
+	int number_of_threads = 0;
+	bool pin = false, parallel_first_touch = false, replicate_terms = false;
+	VisHugePages huge_pages = VIS_HUGE_PAGES_NONE;
+	for(int i = 8; i < argc; i++)
+	{
+		if(!std::strcmp(argv[i], "--wisdom") && i+1 < argc) fft_wisdom_filename = argv[++i];
+		else if(!std::strcmp(argv[i], "--threads") && i+1 < argc) number_of_threads = std::atoi(argv[++i]);
+		else if(!std::strcmp(argv[i], "--pin")) pin = true;
+		else if(!std::strcmp(argv[i], "--first-touch")) parallel_first_touch = true;
+		else if(!std::strcmp(argv[i], "--replicate")) replicate_terms = true;
+		else if(!std::strcmp(argv[i], "--huge-pages") && i+1 < argc)
+		{
+			i++;
+			if(!std::strcmp(argv[i], "transparent")) huge_pages = VIS_HUGE_PAGES_TRANSPARENT;
+			else if(!std::strcmp(argv[i], "explicit")) huge_pages = VIS_HUGE_PAGES_EXPLICIT;
+		}
+		else std::cout << "ignoring " << argv[i] << std::endl;
+	}
+
+	vis_set_number_of_threads(number_of_threads);
+	std::cout << "number of threads: " << vis_get_number_of_threads() << std::endl;
+	if(pin)
+	{
+		std::vector<int> processors(vis_get_number_of_threads());
+		for(int i = 0; i != (int)processors.size(); i++) processors[i] = i;
+		if(!vis_set_thread_affinity(&processors[0], (int)processors.size())) std::cout << "Warning: could not pin the threads" << std::endl;
+	}
+	std::cout << "parallel first touch: " << parallel_first_touch << ", replicated terms: " << replicate_terms << ", huge pages: " << huge_pages << std::endl;
+
+	if(fft_wisdom_filename)
+	{
+		std::cout << "planning the FFT" << (vis_fft_import_wisdom(fft_wisdom_filename) ? " with " : " without ") << "wisdom" << std::endl;
+		vis_fft_warm_up(number_of_samples, cutoff_frequency, VIS_FFT_MEASURE);
+		vis_fft_export_wisdom(fft_wisdom_filename);
+	}
+#endif
+
 	std::cout << "initializing vis config" << std::endl;
 	VisConfig* vis_config = vis_config_create(true, make_float2(1.0, 1.0), cutoff_frequency, make_float3(1.0, 0.0, 0.0), make_float3(0.0, 1.0, 0.0), number_of_samples, block_length, number_of_partial_sums);
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	if(fft_wisdom_filename) vis_config->fft_planning = VIS_FFT_MEASURE;
+	vis_config_place_memory(vis_config, parallel_first_touch, huge_pages);
+	vis_config->replicate_terms = replicate_terms;
+#endif
 	if(!vis_config_check(vis_config)) std::cout << "Warning: Invalid Configuration" << std::endl;
 	else std::cout << "Valid Configuration" << std::endl;
 	
@@ -80,7 +138,13 @@ int main(int argc, char** argv)
 	vis_register_meshless_dataset(vis_config, &meshless_dataset);
 	
 	std::cout << "running code to measure performance" << std::endl;
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	double start = omp_get_wtime();
+#endif
 	for(unsigned int k = 0; k != number_of_runs; ++k) vis_fourier_volume_rendering(&meshless_dataset, vis_config);
+#ifdef _LIBMESHLESSVIS_USE_CPU
+	if(number_of_runs > 0) std::cout << "time per frame: " << 1000.0*(omp_get_wtime() - start)/number_of_runs << " ms" << std::endl;
+#endif
 	std::cout << "finished running tests" << std::endl << std::endl;
 	
 	vis_unregister_meshless_dataset(vis_config, &meshless_dataset);